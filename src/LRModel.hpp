@@ -34,6 +34,14 @@ static const char *const JSON_PATINA_A_Y = "patina_a_y";
 static const char *const JSON_PATINA_B_X = "patina_b_x";
 static const char *const JSON_PATINA_B_Y = "patina_b_y";
 
+static const char *const JSON_OVERSAMPLE_KEY = "oversample";
+
+/* oversampling factors offered to the user, 0 lets the module derive the factor from the sample rate */
+static const int OVERSAMPLING_FACTORS[] = {0, 1, 2, 4, 8, 16};
+
+static const int CONTROL_RATE_DIVIDER = 16;  // number of audio samples per control step
+static const int CACHE_LINE_SIZE = 64;       // alignment of module instances
+
 namespace lrt {
 
 using std::string;
@@ -43,12 +51,64 @@ using std::vector;
 static const string STR_CHECKMARK_UNICODE = "✔";
 
 
+/**
+ * @brief Linear ramp of a control value to audio rate, the target is reached after one control step
+ */
+struct ControlRamp {
+    float value = 0.f;
+    float delta = 0.f;
+    int steps = 0;
+
+
+    /**
+     * @brief Set a new target, the ramp starts at the current value
+     * @param target
+     */
+    void set(float target) {
+        steps = CONTROL_RATE_DIVIDER;
+        delta = (target - value) / steps;
+    }
+
+
+    /**
+     * @brief Jump to a value without ramping
+     * @param target
+     */
+    void reset(float target) {
+        value = target;
+        delta = 0.f;
+        steps = 0;
+    }
+
+
+    /**
+     * @brief Advance by one audio sample
+     * @return Interpolated value
+     */
+    inline float next() {
+        if (steps > 0) {
+            value += delta;
+            steps--;
+        }
+
+        return value;
+    }
+};
+
+
 /**
  * @brief Standard LR Module definition
+ *
+ * step() is split into a control path, which runs once every CONTROL_RATE_DIVIDER samples and reads
+ * knobs, scales CV and updates UI indicators, and an audio path which runs on every sample.
+ * Control values which need to follow smoothly are passed to the audio path with a ControlRamp.
  */
 struct LRModule : public Module {
     LRGestalt *gestalt = nullptr;
 
+    /* samples left until the next control step, 0 runs it on the first sample */
+    int controlCounter = 0;
+
     /**
      * @brief Default constructor derived from rack
      * @param numParams
@@ -57,6 +117,40 @@ struct LRModule : public Module {
      * @param numLights
      */
     explicit LRModule(int numParams, int numInputs, int numOutputs, int numLights);
+
+
+    /**
+     * @brief Allocate modules on a cache line, the DSP state they hold inline is aligned to it
+     *        and plain new ignores alignment above 16 bytes before C++17
+     * @param size
+     * @return
+     */
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
+
+
+    void step() override;
+
+
+    /**
+     * @brief Read the oversampling factor of a patch, only the factors of OVERSAMPLING_FACTORS are accepted
+     * @param rootJ Module JSON
+     * @param fallback Default of the module, used for missing or invalid values
+     * @return
+     */
+    static int oversamplingFromJson(json_t *rootJ, int fallback);
+
+
+    /**
+     * @brief Parameter and UI path, called once every CONTROL_RATE_DIVIDER samples before the audio path
+     */
+    virtual void controlStep() {}
+
+
+    /**
+     * @brief Audio path, called on every sample
+     */
+    virtual void audioStep() {}
 };
 
 
@@ -162,8 +256,37 @@ struct LRModuleWidget : ModuleWidget {
     };
 
 
+    /**
+     * @brief Represents an item for selecting the oversampling factor of a module
+     */
+    struct OversamplingItem : MenuItem {
+        int *factor;
+        int value;
+
+
+        OversamplingItem(int *factor, int value) : factor(factor), value(value) {}
+
+
+        void onAction(EventAction &e) override {
+            *factor = value;
+        }
+
+
+        void step() override {
+            rightText = (*factor == value) ? STR_CHECKMARK_UNICODE : "";
+        }
+    };
+
+
     void step() override;
 
+    /**
+     * @brief Append a section for selecting the oversampling factor
+     * @param menu Context menu of the module
+     * @param factor Factor used by the module, written by the menu items, 0 selects automatic
+     */
+    void appendOversamplingMenu(Menu *menu, int *factor);
+
     /**
      * @brief Create standard menu for all modules
      * @return
@@ -1,5 +1,11 @@
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
 #include "LRComponents.hpp"
 #include "LRModel.hpp"
+#include "dsp/DSPMath.hpp"
 
 using namespace rack;
 using namespace lrt;
@@ -14,4 +20,61 @@ LRModule::LRModule(int numParams, int numInputs, int numOutputs, int numLights)
 }
 
 
+void *LRModule::operator new(size_t size) {
+    void *p;
 
+#ifdef _WIN32
+    p = _aligned_malloc(size, CACHE_LINE_SIZE);
+#else
+    if (posix_memalign(&p, CACHE_LINE_SIZE, size) != 0) p = nullptr;
+#endif
+
+    if (p == nullptr) throw std::bad_alloc();
+
+    return p;
+}
+
+
+void LRModule::operator delete(void *p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+
+int LRModule::oversamplingFromJson(json_t *rootJ, int fallback) {
+    json_t *oversampleJ = json_object_get(rootJ, JSON_OVERSAMPLE_KEY);
+    if (!json_is_integer(oversampleJ)) return fallback;
+
+    json_int_t value = json_integer_value(oversampleJ);
+
+    for (int factor : OVERSAMPLING_FACTORS) {
+        if (value == factor) return factor;
+    }
+
+    return fallback;
+}
+
+
+/**
+ * @brief Run the control path every CONTROL_RATE_DIVIDER samples and the audio path on every sample,
+ *        denormals are flushed to zero from the first step of each engine thread on
+ */
+void LRModule::step() {
+    static thread_local bool flushToZero = false;
+
+    if (!flushToZero) {
+        enableFlushToZero();
+        flushToZero = true;
+    }
+
+    if (controlCounter <= 0) {
+        controlCounter = CONTROL_RATE_DIVIDER;
+        controlStep();
+    }
+
+    controlCounter--;
+    audioStep();
+}
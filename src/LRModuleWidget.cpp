@@ -63,6 +63,22 @@ Menu *LRModuleWidget::createContextMenu() {
 }
 
 
+void LRModuleWidget::appendOversamplingMenu(Menu *menu, int *factor) {
+    auto *spacerLabel = new MenuLabel();
+    menu->addChild(spacerLabel);
+
+    auto *sectionLabel = new MenuLabel();
+    sectionLabel->text = "Oversampling";
+    menu->addChild(sectionLabel);
+
+    for (int value : OVERSAMPLING_FACTORS) {
+        auto *item = new OversamplingItem(factor, value);
+        item->text = value == 0 ? "Auto" : stringf("%dx", value);
+        menu->addChild(item);
+    }
+}
+
+
 /**
  * @brief Load UI relevant settings
  * @return
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+#define ADAA_TABLE_ALIGNMENT 64
+
+
+namespace dsp {
+
+/**
+ * @brief Antiderivative table of an odd nonlinearity for first order antiderivative anti-aliasing
+ *
+ * The antiderivative F(x) is sampled together with f(x) = F'(x) on a uniform grid over [0, range]
+ * and stored as one cubic Hermite segment per grid interval, so a lookup is a few FMAs on a single
+ * 32 byte record. The interpolant is C1 and derivative() is its exact derivative, so the ADAA
+ * difference quotient and the ill-conditioned fallback stay consistent to each other.
+ */
+struct ADAATable {
+    double range;
+    double step, scale;
+    int size;
+
+
+    /**
+     * @brief Sample the nonlinearity and compute the segments
+     * @tparam Shape Provides antiderivative(x) and transfer(x), evaluated only for x >= 0
+     * @param shape Nonlinearity to tabulate
+     * @param range Upper bound of the table, larger arguments have to be computed directly
+     * @param resolution Segments per unit
+     */
+    template<typename Shape>
+    ADAATable(const Shape &shape, double range, int resolution) : range(range) {
+        size = (int) ceil(range * resolution);
+        step = range / size;
+        scale = size / range;
+
+        size_t space = size * sizeof(Segment) + ADAA_TABLE_ALIGNMENT;
+        storage.reset(new char[space]);
+
+        void *ptr = storage.get();
+        segments = (Segment *) std::align(ADAA_TABLE_ALIGNMENT, size * sizeof(Segment), ptr, space);
+
+        /* f may jump at the origin, the first segment needs its limit from the right */
+        double F0 = shape.antiderivative(0.), f0 = shape.transfer(std::numeric_limits<double>::min());
+
+        for (int i = 0; i < size; i++) {
+            double x1 = (i + 1) * step;
+            double F1 = shape.antiderivative(x1), f1 = shape.transfer(x1);
+
+            segments[i].c0 = F0;
+            segments[i].c1 = step * f0;
+            segments[i].c2 = 3. * (F1 - F0) - step * (2. * f0 + f1);
+            segments[i].c3 = 2. * (F0 - F1) + step * (f0 + f1);
+
+            F0 = F1;
+            f0 = f1;
+        }
+    }
+
+
+    ADAATable(const ADAATable &) = delete;
+    ADAATable &operator=(const ADAATable &) = delete;
+
+
+    /**
+     * @brief Check if x can be looked up
+     * @param x
+     * @return
+     */
+    inline bool contains(double x) const {
+        return fabs(x) < range;
+    }
+
+
+    /**
+     * @brief Interpolated antiderivative, F is even
+     * @param x Argument within the range
+     * @return
+     */
+    inline double antiderivative(double x) const {
+        double t = fabs(x) * scale;
+        int i = std::min((int) t, size - 1);
+        const Segment &s = segments[i];
+
+        t -= i;
+
+        return s.c0 + t * (s.c1 + t * (s.c2 + t * s.c3));
+    }
+
+
+    /**
+     * @brief Derivative of the interpolated antiderivative, f is odd
+     * @param x Argument within the range
+     * @return
+     */
+    inline double transfer(double x) const {
+        double t = fabs(x) * scale;
+        int i = std::min((int) t, size - 1);
+        const Segment &s = segments[i];
+
+        t -= i;
+
+        double y = (s.c1 + t * (2. * s.c2 + t * 3. * s.c3)) * scale;
+
+        return x < 0 ? -y : (x > 0 ? y : 0.);
+    }
+
+private:
+    /* polynomial of one grid interval in the local coordinate 0..1 */
+    struct Segment {
+        double c0, c1, c2, c3;
+    };
+
+    std::unique_ptr<char[]> storage;
+    Segment *segments;
+};
+
+}
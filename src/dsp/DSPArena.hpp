@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#define DSP_ALIGNMENT 64            // alignment of heap allocated effects and arenas, one cache line
+
+
+namespace dsp {
+
+/**
+ * @brief Allocate a block on a cache line
+ * @param size
+ * @return
+ */
+inline void *alignedAlloc(size_t size) {
+    void *p;
+
+#ifdef _WIN32
+    p = _aligned_malloc(size, DSP_ALIGNMENT);
+#else
+    if (posix_memalign(&p, DSP_ALIGNMENT, size) != 0) p = nullptr;
+#endif
+
+    if (p == nullptr) throw std::bad_alloc();
+
+    return p;
+}
+
+
+inline void alignedFree(void *p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+
+/**
+ * @brief One cache line aligned block for the filters and histories of a processor
+ *
+ * The owner adds up the footprint of every part and reserves the total once, outside of the
+ * audio thread. The parts are then carved out in the order they are built, so they sit next to
+ * each other in memory. Nothing is freed on its own, objects built with create() are destroyed
+ * by their owner with destroy() before the arena goes.
+ */
+struct DSPArena {
+    char *base = nullptr;
+    size_t size = 0;
+    size_t used = 0;
+
+
+    DSPArena() {}
+
+
+    ~DSPArena() {
+        if (base != nullptr) alignedFree(base);
+    }
+
+
+    DSPArena(const DSPArena &) = delete;
+    DSPArena &operator=(const DSPArena &) = delete;
+
+
+    /**
+     * @brief Space taken by a part, every part starts on its own cache line
+     * @param bytes Size of the part
+     * @return
+     */
+    static size_t footprint(size_t bytes) {
+        return (bytes + DSP_ALIGNMENT - 1) & ~(size_t) (DSP_ALIGNMENT - 1);
+    }
+
+
+    /**
+     * @brief Allocate the block, called once before any part is taken
+     * @param size Sum of the footprints of all parts
+     */
+    void reserve(size_t size) {
+        assert(base == nullptr);
+
+        if (size == 0) return;
+
+        base = (char *) alignedAlloc(size);
+        DSPArena::size = size;
+    }
+
+
+    /**
+     * @brief Take an uninitialized array
+     * @param n Number of elements
+     * @return
+     */
+    template<typename T>
+    T *allocate(int n) {
+        size_t bytes = footprint(n * sizeof(T));
+        assert(used + bytes <= size);
+
+        T *p = reinterpret_cast<T *>(base + used);
+        used += bytes;
+
+        return p;
+    }
+
+
+    /**
+     * @brief Construct an object in the arena
+     * @param args Constructor arguments
+     * @return
+     */
+    template<typename T, typename... Args>
+    T *create(Args &&... args) {
+        return new(allocate<char>(sizeof(T))) T(std::forward<Args>(args)...);
+    }
+
+
+    /**
+     * @brief Destroy an object built with create(), its space stays with the arena
+     * @param p Object or nullptr
+     */
+    template<typename T>
+    static void destroy(T *p) {
+        if (p != nullptr) p->~T();
+    }
+};
+
+}
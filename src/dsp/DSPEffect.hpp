@@ -2,9 +2,19 @@
 
 #include <string.h>
 #include "dsp/ringbuffer.hpp"
+#include "DSPArena.hpp"
+#include "FIRKernel.hpp"
+#include "FIRConvolve.hpp"
+#include "IIRHalfBand.hpp"
 
 #define RS_BUFFER_SIZE 512
-#define UPSAMPLE_COMPENSATION 1.3
+#define RS_MAX_HALFBAND_ORDER 32
+#define RS_MAX_HALFBAND_STAGES 5
+#define RS_MAX_FACTOR 16
+#define RS_FACTOR_STEPS 5           // selectable factors 1, 2, 4, .. RS_MAX_FACTOR
+#define RS_FADE_LENGTH 64
+#define RS_AUTO_FACTOR 0
+#define RS_REFERENCE_RATE 44100.f
 
 
 namespace dsp {
@@ -19,8 +29,30 @@ public:
     float sr = 44100.0;
 
 
-    explicit DSPEffect(float sr) : sr(sr) {
-        init();
+    /**
+     * @brief Constructor, derived classes call init() at the end of their own constructor as a
+     *        virtual call from here only reaches the base
+     * @param sr Sample rate
+     */
+    explicit DSPEffect(float sr) : sr(sr) {}
+
+
+    virtual ~DSPEffect() {}
+
+
+    /**
+     * @brief Allocate effects on a cache line, the lane and stage blocks they hold are aligned and
+     *        plain new ignores alignment above 16 bytes before C++17
+     * @param size
+     * @return
+     */
+    static void *operator new(size_t size) {
+        return alignedAlloc(size);
+    }
+
+
+    static void operator delete(void *p) {
+        alignedFree(p);
     }
 
 
@@ -49,135 +81,481 @@ public:
      * @return
      */
     virtual void process() {};
-};
 
 
-/** The normalized sinc function. https://en.wikipedia.org/wiki/Sinc_function */
-inline double sinc(double x) {
-    if (x == 0.)
-        return 1.;
-    x *= M_PI;
-    return sin(x) / x;
-}
-
-
-/** Computes the impulse response of a boxcar lowpass filter */
-inline void boxcarLowpassIR(double *out, int len, double cutoff = 0.5) {
-    for (int i = 0; i < len; i++) {
-        double t = i - (len - 1) / 2.;
-        out[i] = 2 * cutoff * sinc(2 * cutoff * t);
-    }
-}
+    /**
+     * @brief Process one sample of the main signal path, used by the default processBlock()
+     * @param x Input sample
+     * @return Output sample
+     */
+    virtual float processSample(float x) { return x; };
 
 
-inline void blackmanHarrisWindow(double *x, int len) {
-    // Constants from https://en.wikipedia.org/wiki/Window_function#Blackman%E2%80%93Harris_window
-    const double a0 = 0.35875;
-    const double a1 = 0.48829;
-    const double a2 = 0.14128;
-    const double a3 = 0.01168;
-    double factor = 2 * M_PI / (len - 1);
-    for (int i = 0; i < len; i++) {
-        x[i] *= +a0
-                - a1 * cos(1 * factor * i)
-                + a2 * cos(2 * factor * i)
-                - a3 * cos(3 * factor * i);
+    /**
+     * @brief Process a block of samples, parameters are held for the whole block
+     *
+     * The default calls processSample() for every sample. Effects override this with a loop
+     * which keeps their state in locals and runs the resampler once per block.
+     *
+     * @param in Input samples
+     * @param out Output samples
+     * @param n Number of samples
+     */
+    virtual void processBlock(const float *in, float *out, int n) {
+        for (int i = 0; i < n; i++) {
+            out[i] = processSample(in[i]);
+        }
     }
-}
+};
 
 
+/**
+ * @brief FIR decimator
+ *
+ * The windowed-sinc kernel is symmetric, so it is applied directly to the history window
+ * (newest first) with one vectorized dot product. With more than one channel the history
+ * holds interleaved frames and all channels share the kernel and the dot product.
+ *
+ * @tparam CHANNELS Interleaved channels per frame
+ */
+template<int CHANNELS = 1>
 struct Decimator {
-    double inBuffer[RS_BUFFER_SIZE];
-    double kernel[RS_BUFFER_SIZE];
-    int inIndex;
+    FIRHistory<FIRSample, CHANNELS> history;
+    FIRKernelRef kernel;
     int oversample, quality;
     double cutoff = 0.9;
 
 
-    Decimator(int oversample, int quality) {
+    /**
+     * @brief Constructor
+     * @param oversample Oversampling factor
+     * @param quality Taps per output sample
+     * @param arena Arena with room for footprint(oversample, quality)
+     */
+    Decimator(int oversample, int quality, DSPArena &arena) {
         Decimator::oversample = oversample;
         Decimator::quality = quality;
 
-        boxcarLowpassIR(kernel, oversample * quality, cutoff * 0.5 / oversample);
-        blackmanHarrisWindow(kernel, oversample * quality);
-        reset();
+        kernel = FIRKernelCache::get(KERNEL_LOWPASS, oversample, quality, cutoff);
+        history.init(oversample * quality, arena);
+    }
+
+
+    /**
+     * @brief Space of the decimator and its history in the arena
+     */
+    static size_t footprint(int oversample, int quality) {
+        return DSPArena::footprint(sizeof(Decimator)) + FIRHistory<FIRSample, CHANNELS>::footprint(oversample * quality);
     }
 
 
     void reset() {
-        inIndex = 0;
-        memset(inBuffer, 0, sizeof(inBuffer));
+        history.reset();
     }
 
 
-    /** `in` must be length OVERSAMPLE */
-    float process(double *in) {
-        // Copy input to buffer
-        memcpy(&inBuffer[inIndex], in, oversample * sizeof(double));
-        // Advance index
-        inIndex += oversample;
-        inIndex %= oversample * quality;
-        // Perform naive convolution
-        double out = 0.;
-        for (int i = 0; i < oversample * quality; i++) {
-            int index = inIndex - 1 - i;
-            index = (index + oversample * quality) % (oversample * quality);
-            out += kernel[i] * inBuffer[index];
+    void prime(const double *x) {
+        FIRSample frame[CHANNELS];
+
+        for (int c = 0; c < CHANNELS; c++) {
+            frame[c] = (FIRSample) x[c];
+        }
+
+        history.fillFrame(frame);
+    }
+
+
+    /** `in` must be OVERSAMPLE frames, `out` is one frame */
+    void process(const double *in, double *out) {
+        FIRSample frame[CHANNELS];
+
+        for (int i = 0; i < oversample; i++) {
+            for (int c = 0; c < CHANNELS; c++) {
+                frame[c] = (FIRSample) in[i * CHANNELS + c];
+            }
+
+            history.pushFrame(frame);
+        }
+
+        convolveFrames(kernel->get<FIRSample>(), history.window(), oversample * quality, CHANNELS, frame);
+
+        for (int c = 0; c < CHANNELS; c++) {
+            out[c] = frame[c];
         }
-        return out;
     }
 };
 
 
+/**
+ * @brief Polyphase FIR interpolator
+ *
+ * The prototype lowpass of length OVERSAMPLE * QUALITY is split into OVERSAMPLE sub-kernels
+ * of QUALITY taps each, so every output phase only convolves the real input samples instead
+ * of the zero-stuffed stream. The input history is stored twice in a row, which keeps the
+ * current window contiguous without any modulo or branch on the taps.
+ *
+ * Polynomial interpolators (Hermite, Lagrange) use the same layout with their weights per
+ * phase as sub-kernels.
+ *
+ * @tparam CHANNELS Interleaved channels per frame
+ */
+template<int CHANNELS = 1>
 struct Upsampler {
-    double inBuffer[RS_BUFFER_SIZE];
-    double kernel[RS_BUFFER_SIZE];
-    int inIndex;
+    FIRHistory<FIRSample, CHANNELS> history;
+    FIRKernelRef kernel;
+    FIRKernelType type;
     int oversample, quality;
     double cutoff = 0.9;
 
 
-    Upsampler(int oversample, int quality) {
+    /**
+     * @brief Set up the interpolator
+     * @param oversample Oversampling factor
+     * @param quality Taps per phase, the number of points for polynomial interpolators
+     * @param type KERNEL_POLYPHASE, KERNEL_HERMITE or KERNEL_LAGRANGE
+     * @param arena Arena with room for footprint(oversample, quality)
+     */
+    Upsampler(int oversample, int quality, FIRKernelType type, DSPArena &arena) {
         Upsampler::oversample = oversample;
         Upsampler::quality = quality;
+        Upsampler::type = type;
+
+        kernel = FIRKernelCache::get(type, oversample, quality, type == KERNEL_POLYPHASE ? cutoff : 0.);
+        history.init(quality, arena);
+    }
 
-        boxcarLowpassIR(kernel, oversample * quality, cutoff * 0.5 / oversample);
-        blackmanHarrisWindow(kernel, oversample * quality);
-        reset();
+
+    /**
+     * @brief Space of the interpolator and its history in the arena
+     */
+    static size_t footprint(int oversample, int quality) {
+        return DSPArena::footprint(sizeof(Upsampler)) + FIRHistory<FIRSample, CHANNELS>::footprint(quality);
     }
 
 
     void reset() {
-        inIndex = 0;
-        memset(inBuffer, 0, sizeof(inBuffer));
+        history.reset();
+    }
+
+
+    void prime(const double *x) {
+        FIRSample frame[CHANNELS];
+
+        for (int c = 0; c < CHANNELS; c++) {
+            frame[c] = (FIRSample) x[c];
+        }
+
+        history.fillFrame(frame);
     }
 
 
-    /** `out` must be length OVERSAMPLE */
-    void process(double in, double *out) {
-        // Zero-stuff input buffer
-        inBuffer[inIndex] = oversample * in;
-        // Advance index
-        inIndex++;
-        inIndex %= quality;
-        // Naively convolve each sample
-        // TODO replace with polyphase filter hierarchy
+    /** `in` is one frame, `out` must be OVERSAMPLE frames */
+    void process(const double *in, double *out) {
+        FIRSample frame[CHANNELS];
+
+        for (int c = 0; c < CHANNELS; c++) {
+            frame[c] = (FIRSample) in[c];
+        }
+
+        history.pushFrame(frame);
+
+        const FIRSample *x = history.window();
+        const FIRSample *h = kernel->get<FIRSample>();
+
+        // Convolve each phase with its sub-kernel
         for (int i = 0; i < oversample; i++) {
-            float y = 0.0;
-            for (int j = 0; j < quality; j++) {
-                int index = inIndex - 1 - j;
-                index = (index + quality) % quality;
-                int kernelIndex = oversample * j + i;
-                y += kernel[kernelIndex] * inBuffer[index];
+            convolveFrames(&h[quality * i], x, quality, CHANNELS, frame);
+
+            for (int c = 0; c < CHANNELS; c++) {
+                out[i * CHANNELS + c] = frame[c];
             }
-            out[i] = y;
         }
     }
 };
 
 
+/**
+ * @brief One 2x decimation stage with a half-band FIR
+ *
+ * Every second tap of a half-band kernel is zero, only the center tap (0.5) and the
+ * odd taps around it remain. The input is split into an even and an odd stream: the
+ * even stream is convolved with the non-zero taps, the odd stream is just delayed for
+ * the center tap. A kernel of 4 * ORDER - 1 taps costs 2 * ORDER + 1 multiplications
+ * per output sample, all of them in one contiguous dot product.
+ *
+ * @tparam CHANNELS Interleaved channels per frame
+ */
+template<int CHANNELS = 1>
+struct HalfBandStage {
+    FIRHistory<FIRSample, CHANNELS> even;
+    FIRHistory<FIRSample, CHANNELS> odd;
+    FIRKernelRef kernel;
+    int order = 0;
+
+
+    /**
+     * @brief Space of both histories in the arena
+     * @param order Number of non-zero taps on each side of the center
+     * @return
+     */
+    static size_t footprint(int order) {
+        return FIRHistory<FIRSample, CHANNELS>::footprint(2 * order) + FIRHistory<FIRSample, CHANNELS>::footprint(order);
+    }
+
+
+    /**
+     * @brief Set up the stage and fetch the shared kernel for a given order, called once
+     * @param order Number of non-zero taps on each side of the center
+     * @param arena Arena of the decimator
+     */
+    void init(int order, DSPArena &arena) {
+        HalfBandStage::order = order;
+
+        kernel = FIRKernelCache::get(KERNEL_HALFBAND, 2, order, 0.5);
+        even.init(2 * order, arena);
+        odd.init(order, arena);
+    }
+
+
+    void reset() {
+        even.reset();
+        odd.reset();
+    }
+
+
+    void prime(const double *x) {
+        FIRSample frame[CHANNELS];
+
+        for (int c = 0; c < CHANNELS; c++) {
+            frame[c] = (FIRSample) x[c];
+        }
+
+        even.fillFrame(frame);
+        odd.fillFrame(frame);
+    }
+
+
+    /**
+     * @brief Consume two frames and return one decimated frame
+     * @param x0 Older frame
+     * @param x1 Newer frame
+     * @param out Destination for one frame, may be the same as x0
+     */
+    void process(const double *x0, const double *x1, double *out) {
+        FIRSample frame[CHANNELS];
+
+        for (int c = 0; c < CHANNELS; c++) {
+            frame[c] = (FIRSample) x1[c];
+        }
+
+        even.pushFrame(frame);
+
+        for (int c = 0; c < CHANNELS; c++) {
+            frame[c] = (FIRSample) x0[c];
+        }
+
+        odd.pushFrame(frame);
+
+        convolveFrames(kernel->get<FIRSample>(), even.window(), 2 * order, CHANNELS, frame);
+
+        const FIRSample *center = &odd.window()[(order - 1) * CHANNELS];
+
+        for (int c = 0; c < CHANNELS; c++) {
+            out[c] = 0.5 * center[c] + frame[c];
+        }
+    }
+};
+
+
+/**
+ * @brief Decimator built from a cascade of 2x half-band stages
+ *
+ * The last stage runs at the target rate and needs the steepest transition, earlier
+ * stages only have to protect the final passband and are kept shorter.
+ *
+ * @tparam CHANNELS Interleaved channels per frame
+ */
+template<int CHANNELS = 1>
+struct HalfBandDecimator {
+    HalfBandStage<CHANNELS> stages[RS_MAX_HALFBAND_STAGES];
+    int oversample, numStages;
+
+
+    /**
+     * @brief Set up the cascade for a given factor
+     * @param oversample Oversampling factor, must be a power of two
+     * @param quality Order of the last stage
+     * @param arena Arena with room for footprint(oversample, quality)
+     */
+    HalfBandDecimator(int oversample, int quality, DSPArena &arena) {
+        HalfBandDecimator::oversample = oversample;
+        numStages = countStages(oversample);
+
+        /* stages are ordered from the highest rate down to the target rate */
+        int order = clampOrder(quality);
+
+        for (int i = numStages - 1; i >= 0; i--) {
+            stages[i].init(order, arena);
+            order = clampOrder(order / 2);
+        }
+    }
+
+
+    /**
+     * @brief Space of the cascade and the histories of all stages in the arena
+     * @param oversample Oversampling factor, must be a power of two
+     * @param quality Order of the last stage
+     * @return
+     */
+    static size_t footprint(int oversample, int quality) {
+        size_t bytes = DSPArena::footprint(sizeof(HalfBandDecimator));
+        int order = clampOrder(quality);
+
+        for (int i = 0; i < countStages(oversample); i++) {
+            bytes += HalfBandStage<CHANNELS>::footprint(order);
+            order = clampOrder(order / 2);
+        }
+
+        return bytes;
+    }
+
+
+    static int countStages(int oversample) {
+        int n = 0;
+
+        while ((1 << n) < oversample && n < RS_MAX_HALFBAND_STAGES) {
+            n++;
+        }
+
+        return n;
+    }
+
+
+    static int clampOrder(int order) {
+        if (order < 2) return 2;
+        if (order > RS_MAX_HALFBAND_ORDER) return RS_MAX_HALFBAND_ORDER;
+        return order;
+    }
+
+
+    /**
+     * @brief Check if a factor can be handled by a cascade of 2x stages
+     * @param oversample
+     * @return
+     */
+    static bool supports(int oversample) {
+        return oversample > 1 && (oversample & (oversample - 1)) == 0 &&
+               oversample <= (1 << RS_MAX_HALFBAND_STAGES);
+    }
+
+
+    void reset() {
+        for (int i = 0; i < numStages; i++) {
+            stages[i].reset();
+        }
+    }
+
+
+    void prime(const double *x) {
+        for (int i = 0; i < numStages; i++) {
+            stages[i].prime(x);
+        }
+    }
+
+
+    /** `in` must be OVERSAMPLE frames, `out` is one frame */
+    void process(const double *in, double *out) {
+        double buffer[(1 << RS_MAX_HALFBAND_STAGES) * CHANNELS];
+        memcpy(buffer, in, oversample * CHANNELS * sizeof(double));
+
+        // Halve the data in place stage by stage
+        int n = oversample;
+
+        for (int i = 0; i < numStages; i++) {
+            n /= 2;
+
+            for (int j = 0; j < n; j++) {
+                stages[i].process(&buffer[2 * j * CHANNELS], &buffer[(2 * j + 1) * CHANNELS], &buffer[j * CHANNELS]);
+            }
+        }
+
+        memcpy(out, buffer, CHANNELS * sizeof(double));
+    }
+};
+
+
+/**
+ * @brief Automatic oversampling policy
+ *
+ * Picks the smallest power of two which lifts the host rate to the internal rate a processor
+ * was tuned for. Sessions at 96 kHz or 192 kHz already have the headroom and drop to 1x - 2x.
+ *
+ * @param factor Requested factor, RS_AUTO_FACTOR to derive it from the sample rate
+ * @param sr Host sample rate
+ * @param targetRate Internal sample rate to reach
+ * @return Factor to use
+ */
+inline int resolveOversampling(int factor, float sr, float targetRate) {
+    if (factor != RS_AUTO_FACTOR) return factor;
+
+    int result = 1;
+
+    /* small tolerance, so 4x at 44.1 kHz stays 4x for a target of 176.4 kHz */
+    while (sr * result < targetRate * 0.95f && result < RS_MAX_FACTOR) {
+        result *= 2;
+    }
+
+    return result;
+}
+
+
+/**
+ * @brief Upsampling methods supported by the resampler
+ */
+enum UpsamplingType {
+    UPSAMPLE_LINEAR,    // interpolation between the last two input samples, cheap but not band-limited
+    UPSAMPLE_POLYPHASE, // band-limited polyphase FIR interpolator
+    UPSAMPLE_IIR,       // cascade of 2x IIR half-band stages, low latency, used in low latency mode
+    UPSAMPLE_HERMITE,   // 4-point cubic Hermite, one sample more latency than linear
+    UPSAMPLE_LAGRANGE   // 6-point Lagrange, two samples more latency than linear
+};
+
+
+/**
+ * @brief Downsampling methods supported by the resampler
+ */
+enum DownsamplingType {
+    DOWNSAMPLE_FIR,     // single windowed-sinc FIR over the whole oversampled block
+    DOWNSAMPLE_HALFBAND,// cascade of 2x half-band stages, power of two factors only
+    DOWNSAMPLE_IIR      // cascade of 2x IIR half-band stages, low latency, used in low latency mode
+};
+
+
+/**
+ * @brief Factors a resampler can be switched to after construction
+ */
+enum ResamplerFactors {
+    RS_FIXED_FACTOR,    // keeps the factor of the constructor, only its filters are built
+    RS_ANY_FACTOR       // setFactor() selects any power of two up to RS_MAX_FACTOR
+};
+
+
 /**
  * @brief NEW oversampling class
+ *
+ * The factor and the latency mode can be changed while running. The filters of every factor
+ * the resampler can select and both latency modes are built in the constructor, so a switch
+ * only selects and primes them with the current signal level, without any allocation or kernel
+ * lookup on the audio thread. The remaining step caused by the changed group delay is smoothed
+ * by a short ramp from the last output. Resamplers with a fixed factor only build the filters
+ * of that factor, none at all for 1x.
+ *
+ * Filters, their histories and the mono buffers are placed in one arena, each history sized
+ * to its filter length.
+ *
+ * All channels run through one set of filters on interleaved frames (see upsampleFrame() and
+ * downsampleFrame()), so the kernel is loaded once per tap and the channels share the SIMD
+ * lanes. The per-channel methods are kept for mono processors.
  */
 template<int CHANNELS>
 struct Resampler {
@@ -186,65 +564,520 @@ struct Resampler {
     };
 
     Vector y[CHANNELS] = {};
-    double up[CHANNELS][RS_BUFFER_SIZE] = {};
-    double data[CHANNELS][RS_BUFFER_SIZE] = {};
 
-    Decimator *decimator[CHANNELS];
-    Upsampler *interpolator[CHANNELS];
+    /* buffers for the per-channel methods, only mono resamplers have them */
+    double *up[CHANNELS] = {};
+    double *data[CHANNELS] = {};
+
+    DSPArena arena;
+
+    /* filters of one factor, only the ones the configured methods can select are built */
+    struct FilterSet {
+        Decimator<CHANNELS> *decimator = nullptr;
+        HalfBandDecimator<CHANNELS> *halfband = nullptr;
+        Upsampler<CHANNELS> *interpolator = nullptr;
+        IIRHalfBandCascade<CHANNELS> *iirUp = nullptr;
+        IIRHalfBandCascade<CHANNELS> *iirDown = nullptr;
+    };
+
+    FilterSet sets[RS_FACTOR_STEPS];
 
-    int oversample;
+    /* filters of the current factor */
+    Decimator<CHANNELS> *decimator = nullptr;
+    HalfBandDecimator<CHANNELS> *halfband = nullptr;
+    Upsampler<CHANNELS> *interpolator = nullptr;
+    IIRHalfBandCascade<CHANNELS> *iirUp = nullptr;
+    IIRHalfBandCascade<CHANNELS> *iirDown = nullptr;
+
+    /* last output and ramp state for switching */
+    double last[CHANNELS] = {};
+    double hold[CHANNELS] = {};
+    int fade[CHANNELS] = {};
+
+    int oversample, quality;
+    UpsamplingType upsampling, activeUpsampling;
+    DownsamplingType downsampling, activeDownsampling;
+    ResamplerFactors factors;
+    bool lowLatency = false;
 
 
     /**
-     * @brief Constructor
-     * @param factor Oversampling factor
+     * @brief Constructor, builds the filters of all selectable factors into the arena
+     * @param factor Oversampling factor, rounded down to a power of two
+     * @param quality Filter taps per input sample
+     * @param upsampling Method used to create the up-sampled data
+     * @param downsampling Method used to decimate
+     * @param factors RS_ANY_FACTOR if setFactor() is used, a fixed resampler only builds its own factor
      */
-    Resampler(int oversample, int quality = 4) {
-        Resampler::oversample = oversample;
+    Resampler(int oversample, int quality = 4, UpsamplingType upsampling = UPSAMPLE_LINEAR,
+              DownsamplingType downsampling = DOWNSAMPLE_FIR, ResamplerFactors factors = RS_FIXED_FACTOR) {
+        Resampler::oversample = clampFactor(oversample);
+        Resampler::quality = quality;
+        Resampler::upsampling = upsampling;
+        Resampler::downsampling = downsampling;
+        Resampler::factors = factors;
 
-        for (int i = 0; i < CHANNELS; i++) {
-            decimator[i] = new Decimator(oversample, quality);
-            interpolator[i] = new Upsampler(oversample, quality);
+        /* size the arena for everything which can be selected, then build into it */
+        size_t size = 0;
+
+        if (CHANNELS == 1) {
+            size += 2 * DSPArena::footprint(RS_BUFFER_SIZE * sizeof(double));
+        }
+
+        for (int i = 1; i < RS_FACTOR_STEPS; i++) {
+            if (isSelectable(1 << i)) size += footprint(1 << i);
+        }
+
+        arena.reserve(size);
+
+        if (CHANNELS == 1) {
+            up[0] = arena.allocate<double>(RS_BUFFER_SIZE);
+            data[0] = arena.allocate<double>(RS_BUFFER_SIZE);
+
+            memset(up[0], 0, RS_BUFFER_SIZE * sizeof(double));
+            memset(data[0], 0, RS_BUFFER_SIZE * sizeof(double));
+        }
+
+        for (int i = 1; i < RS_FACTOR_STEPS; i++) {
+            if (isSelectable(1 << i)) build(sets[i], 1 << i);
+        }
+
+        configure();
+    }
+
+
+    ~Resampler() {
+        for (int i = 0; i < RS_FACTOR_STEPS; i++) {
+            DSPArena::destroy(sets[i].decimator);
+            DSPArena::destroy(sets[i].halfband);
+            DSPArena::destroy(sets[i].interpolator);
+            DSPArena::destroy(sets[i].iirUp);
+            DSPArena::destroy(sets[i].iirDown);
         }
     }
 
 
+    /* owns its filters */
+    Resampler(const Resampler &) = delete;
+    Resampler &operator=(const Resampler &) = delete;
+
+
     int getFactor() {
         return oversample;
     }
 
 
+    /**
+     * @brief Limit a factor to 1..RS_MAX_FACTOR and round it down to a power of two
+     * @param oversample
+     * @return
+     */
+    static int clampFactor(int oversample) {
+        int factor = 1;
+
+        while (factor * 2 <= oversample && factor < RS_MAX_FACTOR) {
+            factor *= 2;
+        }
+
+        return factor;
+    }
+
+
+    /**
+     * @brief Index of a power of two factor in sets
+     */
+    static int factorIndex(int oversample) {
+        int i = 0;
+
+        while ((1 << i) < oversample) {
+            i++;
+        }
+
+        return i;
+    }
+
+
+    /**
+     * @brief Check if the filters of a factor are built
+     * @param oversample Factor, a power of two
+     * @return
+     */
+    bool isSelectable(int oversample) const {
+        return factors == RS_ANY_FACTOR || oversample == Resampler::oversample;
+    }
+
+
+    /**
+     * @brief Change the oversampling factor while running, allocation free. Resamplers built with
+     *        RS_FIXED_FACTOR keep their factor.
+     * @param oversample New factor, 1 passes the signal through, rounded down to a power of two
+     */
+    void setFactor(int oversample) {
+        oversample = clampFactor(oversample);
+
+        if (oversample == Resampler::oversample || !isSelectable(oversample)) return;
+
+        Resampler::oversample = oversample;
+        configure();
+        ramp();
+    }
+
+
+    /**
+     * @brief Switch between the linear-phase FIR filters and the IIR half-band cascade
+     *
+     * The IIR path delays the signal by a few samples only, which keeps the latency of long
+     * chains and feedback loops low, at the price of a non-linear phase near the cutoff.
+     * Factors which are no power of two always stay on the FIR filters.
+     *
+     * @param lowLatency
+     */
+    void setLowLatency(bool lowLatency) {
+        if (lowLatency == Resampler::lowLatency) return;
+
+        Resampler::lowLatency = lowLatency;
+        configure();
+        ramp();
+    }
+
+
+    bool isLowLatency() const {
+        return lowLatency;
+    }
+
+
+    bool hasInterpolator() const {
+        return upsampling == UPSAMPLE_POLYPHASE || upsampling == UPSAMPLE_HERMITE || upsampling == UPSAMPLE_LAGRANGE;
+    }
+
+
+    bool hasHalfband(int oversample) const {
+        return downsampling == DOWNSAMPLE_HALFBAND && HalfBandDecimator<CHANNELS>::supports(oversample);
+    }
+
+
+    /**
+     * @brief Space taken by the filters of one factor in the arena, follows build()
+     * @param oversample Factor, a power of two
+     * @return
+     */
+    size_t footprint(int oversample) {
+        size_t bytes = 0;
+
+        if (hasInterpolator()) {
+            bytes += Upsampler<CHANNELS>::footprint(oversample, getKernelTaps(upsampling));
+        }
+
+        if (hasHalfband(oversample)) {
+            bytes += HalfBandDecimator<CHANNELS>::footprint(oversample, quality);
+        } else {
+            bytes += Decimator<CHANNELS>::footprint(oversample, quality);
+        }
+
+        if (IIRHalfBandCascade<CHANNELS>::supports(oversample)) {
+            bytes += 2 * IIRHalfBandCascade<CHANNELS>::footprint(oversample, quality / 2);
+        }
+
+        return bytes;
+    }
+
+
+    /**
+     * @brief Build the filters of one factor for the configured methods, both latency modes
+     * @param set Destination
+     * @param oversample Factor, a power of two
+     */
+    void build(FilterSet &set, int oversample) {
+        if (hasInterpolator()) {
+            set.interpolator = arena.create<Upsampler<CHANNELS>>(oversample, getKernelTaps(upsampling),
+                                                                  getKernelType(upsampling), arena);
+        }
+
+        if (hasHalfband(oversample)) {
+            set.halfband = arena.create<HalfBandDecimator<CHANNELS>>(oversample, quality, arena);
+        } else {
+            set.decimator = arena.create<Decimator<CHANNELS>>(oversample, quality, arena);
+        }
+
+        if (IIRHalfBandCascade<CHANNELS>::supports(oversample)) {
+            set.iirUp = arena.create<IIRHalfBandCascade<CHANNELS>>(oversample, quality / 2, arena);
+            set.iirDown = arena.create<IIRHalfBandCascade<CHANNELS>>(oversample, quality / 2, arena);
+        }
+    }
+
+
+    /**
+     * @brief Select the filters for the current settings and prime them with the current signal
+     *        level of each channel. Runs on the audio thread, all filters exist already.
+     */
+    void configure() {
+        bool iir = lowLatency && IIRHalfBandCascade<CHANNELS>::supports(oversample);
+
+        activeUpsampling = iir ? UPSAMPLE_IIR : upsampling;
+        activeDownsampling = iir ? DOWNSAMPLE_IIR : downsampling;
+
+        if (oversample == 1) return;
+
+        FilterSet &set = sets[factorIndex(oversample)];
+
+        decimator = set.decimator;
+        halfband = set.halfband;
+        interpolator = set.interpolator;
+        iirUp = set.iirUp;
+        iirDown = set.iirDown;
+
+        if (activeDownsampling == DOWNSAMPLE_HALFBAND && halfband == nullptr) {
+            activeDownsampling = DOWNSAMPLE_FIR;
+        }
+
+        double level[CHANNELS];
+
+        for (int i = 0; i < CHANNELS; i++) {
+            level[i] = y[i].y1;
+        }
+
+        switch (activeUpsampling) {
+            case UPSAMPLE_POLYPHASE:
+            case UPSAMPLE_HERMITE:
+            case UPSAMPLE_LAGRANGE:
+                interpolator->prime(level);
+                break;
+            case UPSAMPLE_IIR:
+                iirUp->prime(level);
+                break;
+            default:
+                break;
+        }
+
+        switch (activeDownsampling) {
+            case DOWNSAMPLE_FIR:
+                decimator->prime(last);
+                break;
+            case DOWNSAMPLE_HALFBAND:
+                halfband->prime(last);
+                break;
+            case DOWNSAMPLE_IIR:
+                iirDown->prime(last);
+                break;
+        }
+    }
+
+
+    static FIRKernelType getKernelType(UpsamplingType type) {
+        switch (type) {
+            case UPSAMPLE_HERMITE:
+                return KERNEL_HERMITE;
+            case UPSAMPLE_LAGRANGE:
+                return KERNEL_LAGRANGE;
+            default:
+                return KERNEL_POLYPHASE;
+        }
+    }
+
+
+    int getKernelTaps(UpsamplingType type) {
+        switch (type) {
+            case UPSAMPLE_HERMITE:
+                return 4;
+            case UPSAMPLE_LAGRANGE:
+                return 6;
+            default:
+                return quality;
+        }
+    }
+
+
+    /**
+     * @brief Start the output ramp of all channels after a switch
+     */
+    void ramp() {
+        for (int i = 0; i < CHANNELS; i++) {
+            hold[i] = last[i];
+            fade[i] = RS_FADE_LENGTH;
+        }
+    }
+
+
     /**
      * @brief Return linear interpolated position
      * @param point Point in oversampled data
      * @return
      */
     double interpolate(int channel, int point) {
-        return y[channel].y0 + (point / getFactor()) * (y[channel].y1 - y[channel].y0);
+        return y[channel].y0 + (double) point / getFactor() * (y[channel].y1 - y[channel].y0);
     }
 
 
     /**
-     * @brief Create up-sampled data out of two basic values
+     * @brief Up-sample one frame of all channels
+     * @param in One sample per channel
+     * @param out Destination for FACTOR interleaved frames
      */
-    void doUpsample(int channel, double in) {
-        // interpolator[channel]->process(in * UPSAMPLE_COMPENSATION, up[channel]);
-        y[channel].y0 = y[channel].y1;
-        y[channel].y1 = in;
+    void upsampleFrame(const double *in, double *out) {
+        for (int c = 0; c < CHANNELS; c++) {
+            y[c].y0 = y[c].y1;
+            y[c].y1 = in[c];
+        }
+
+        if (oversample == 1) {
+            memcpy(out, in, CHANNELS * sizeof(double));
+            return;
+        }
+
+        switch (activeUpsampling) {
+            case UPSAMPLE_POLYPHASE:
+            case UPSAMPLE_HERMITE:
+            case UPSAMPLE_LAGRANGE:
+                interpolator->process(in, out);
+                break;
+            case UPSAMPLE_IIR:
+                iirUp->upsample(in, out);
+                break;
+            default:
+                for (int i = 0; i < getFactor(); i++) {
+                    for (int c = 0; c < CHANNELS; c++) {
+                        out[i * CHANNELS + c] = interpolate(c, i + 1);
+                    }
+                }
+                break;
+        }
+    }
+
+
+    /**
+     * @brief Decimate FACTOR frames of all channels into one
+     * @param in FACTOR interleaved frames
+     * @param out Destination for one sample per channel
+     */
+    void downsampleFrame(const double *in, double *out) {
+        if (oversample == 1) {
+            memcpy(out, in, CHANNELS * sizeof(double));
+        } else if (activeDownsampling == DOWNSAMPLE_IIR) {
+            iirDown->downsample(in, out);
+        } else if (activeDownsampling == DOWNSAMPLE_HALFBAND) {
+            halfband->process(in, out);
+        } else {
+            decimator->process(in, out);
+        }
+
+        for (int c = 0; c < CHANNELS; c++) {
+            /* ramp from the output before the last switch */
+            if (fade[c] > 0) {
+                out[c] += (hold[c] - out[c]) * fade[c] / RS_FADE_LENGTH;
+                fade[c]--;
+            }
+
+            last[c] = out[c];
+        }
+    }
 
-        for (int i = 0; i < getFactor(); i++) {
-            up[channel][i] = interpolate(channel, i + 1);
+
+    /**
+     * @brief Up-sample a block of interleaved frames
+     * @param in N frames
+     * @param out Destination for N * FACTOR frames
+     * @param n Number of input frames
+     */
+    void upsampleFrames(const double *in, double *out, int n) {
+        for (int i = 0; i < n; i++) {
+            upsampleFrame(&in[i * CHANNELS], &out[i * oversample * CHANNELS]);
+        }
+    }
+
+
+    /**
+     * @brief Decimate a block of interleaved oversampled frames back to host rate
+     * @param in N * FACTOR frames
+     * @param out Destination for N frames
+     * @param n Number of output frames
+     */
+    void downsampleFrames(const double *in, double *out, int n) {
+        for (int i = 0; i < n; i++) {
+            downsampleFrame(&in[i * oversample * CHANNELS], &out[i * CHANNELS]);
         }
     }
 
 
+    /**
+     * @brief Up-sample one input sample of a mono resampler
+     * @param channel Channel to process
+     * @param in Input sample
+     * @param out Destination for FACTOR samples
+     */
+    void upsample(int channel, double in, double *out) {
+        static_assert(CHANNELS == 1, "multi-channel resamplers process whole frames, use upsampleFrame()");
+        upsampleFrame(&in, out);
+    }
+
+
+    /**
+     * @brief Decimate FACTOR samples of a mono resampler into one
+     * @param channel Channel to process
+     * @param in FACTOR oversampled samples
+     * @return Downsampled point
+     */
+    double downsample(int channel, const double *in) {
+        static_assert(CHANNELS == 1, "multi-channel resamplers process whole frames, use downsampleFrame()");
+
+        double out;
+        downsampleFrame(in, &out);
+
+        return out;
+    }
+
+
+    /**
+     * @brief Create up-sampled data out of two basic values
+     */
+    void doUpsample(int channel, double in) {
+        upsample(channel, in, up[channel]);
+    }
+
+
     /**
      * @brief Downsampled data from a given channel
      * @param channel Channel to proccess
      * @return Downsampled point
      */
     double getDownsampled(int channel) {
-        return decimator[channel]->process(data[channel]);
+        return downsample(channel, data[channel]);
+    }
+
+
+    /**
+     * @brief Up-sample a block of host samples into one contiguous buffer
+     * @param channel Channel to process
+     * @param in N input samples
+     * @param out Destination for N * FACTOR samples
+     * @param n Number of input samples
+     */
+    void upsampleBlock(int channel, const double *in, double *out, int n) {
+        for (int i = 0; i < n; i++) {
+            upsample(channel, in[i], &out[i * oversample]);
+        }
+    }
+
+
+    /**
+     * @brief Decimate a contiguous oversampled block back to host rate
+     * @param channel Channel to process
+     * @param in N * FACTOR oversampled samples
+     * @param out Destination for N samples
+     * @param n Number of output samples
+     */
+    void downsampleBlock(int channel, const double *in, double *out, int n) {
+        for (int i = 0; i < n; i++) {
+            out[i] = downsample(channel, &in[i * oversample]);
+        }
+    }
+
+
+    /**
+     * @brief Maximum number of host samples which fit into the internal buffers at once
+     * @return
+     */
+    int getBlockSize() {
+        return RS_BUFFER_SIZE / oversample;
     }
 
 
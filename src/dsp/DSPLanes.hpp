@@ -0,0 +1,266 @@
+#pragma once
+
+#include <math.h>
+#include "DSPMath.hpp"
+
+/* lane packs only stay in registers inside one function, so their per sample kernels must be inlined */
+#define LANE_INLINE inline __attribute__((always_inline))
+
+
+namespace dsp {
+
+/**
+ * @brief Pack of independent voices which are processed in the same instructions
+ *
+ * Every operation is a fixed size loop over an aligned array, which the compiler maps to
+ * SSE (4 lanes) or AVX (8 lanes) registers. Scalars are broadcast to all lanes, so the
+ * filter code reads the same as its single voice version.
+ *
+ * @tparam LANES Number of voices, 4 or 8
+ */
+template<int LANES>
+struct alignas(LANES * sizeof(float)) FloatLanes {
+    float v[LANES];
+
+
+    FloatLanes() = default;
+
+
+    FloatLanes(float x) {
+        for (int i = 0; i < LANES; i++) v[i] = x;
+    }
+
+
+    static FloatLanes load(const float *p) {
+        FloatLanes r;
+        for (int i = 0; i < LANES; i++) r.v[i] = p[i];
+        return r;
+    }
+
+
+    void store(float *p) const {
+        for (int i = 0; i < LANES; i++) p[i] = v[i];
+    }
+
+
+    inline float &operator[](int i) {
+        return v[i];
+    }
+
+
+    inline float operator[](int i) const {
+        return v[i];
+    }
+
+
+    inline FloatLanes &operator+=(const FloatLanes &b) {
+        for (int i = 0; i < LANES; i++) v[i] += b.v[i];
+        return *this;
+    }
+
+
+    inline FloatLanes &operator-=(const FloatLanes &b) {
+        for (int i = 0; i < LANES; i++) v[i] -= b.v[i];
+        return *this;
+    }
+
+
+    inline FloatLanes &operator*=(const FloatLanes &b) {
+        for (int i = 0; i < LANES; i++) v[i] *= b.v[i];
+        return *this;
+    }
+
+
+    inline FloatLanes &operator/=(const FloatLanes &b) {
+        for (int i = 0; i < LANES; i++) v[i] /= b.v[i];
+        return *this;
+    }
+};
+
+
+typedef FloatLanes<4> Float4;
+typedef FloatLanes<8> Float8;
+
+
+/**
+ * @brief Number of voices held by a sample type, float is a single voice
+ */
+template<typename T>
+struct LaneCount {
+    static const int value = 1;
+};
+
+
+template<int LANES>
+struct LaneCount<FloatLanes<LANES>> {
+    static const int value = LANES;
+};
+
+
+template<int LANES>
+inline FloatLanes<LANES> operator+(FloatLanes<LANES> a, const FloatLanes<LANES> &b) {
+    return a += b;
+}
+
+
+template<int LANES>
+inline FloatLanes<LANES> operator-(FloatLanes<LANES> a, const FloatLanes<LANES> &b) {
+    return a -= b;
+}
+
+
+template<int LANES>
+inline FloatLanes<LANES> operator*(FloatLanes<LANES> a, const FloatLanes<LANES> &b) {
+    return a *= b;
+}
+
+
+template<int LANES>
+inline FloatLanes<LANES> operator/(FloatLanes<LANES> a, const FloatLanes<LANES> &b) {
+    return a /= b;
+}
+
+
+template<int LANES>
+inline FloatLanes<LANES> operator+(FloatLanes<LANES> a, float b) {
+    return a += FloatLanes<LANES>(b);
+}
+
+
+template<int LANES>
+inline FloatLanes<LANES> operator+(float a, const FloatLanes<LANES> &b) {
+    return FloatLanes<LANES>(a) += b;
+}
+
+
+template<int LANES>
+inline FloatLanes<LANES> operator-(FloatLanes<LANES> a, float b) {
+    return a -= FloatLanes<LANES>(b);
+}
+
+
+template<int LANES>
+inline FloatLanes<LANES> operator-(float a, const FloatLanes<LANES> &b) {
+    return FloatLanes<LANES>(a) -= b;
+}
+
+
+template<int LANES>
+inline FloatLanes<LANES> operator*(FloatLanes<LANES> a, float b) {
+    return a *= FloatLanes<LANES>(b);
+}
+
+
+template<int LANES>
+inline FloatLanes<LANES> operator*(float a, const FloatLanes<LANES> &b) {
+    return FloatLanes<LANES>(a) *= b;
+}
+
+
+template<int LANES>
+inline FloatLanes<LANES> operator/(FloatLanes<LANES> a, float b) {
+    return a /= FloatLanes<LANES>(b);
+}
+
+
+template<int LANES>
+inline FloatLanes<LANES> operator/(float a, const FloatLanes<LANES> &b) {
+    return FloatLanes<LANES>(a) /= b;
+}
+
+
+template<int LANES>
+inline FloatLanes<LANES> operator-(const FloatLanes<LANES> &a) {
+    return FloatLanes<LANES>(0.f) -= a;
+}
+
+
+}
+
+
+/* lane math lives next to the scalar helpers of DSPMath, so both overloads are found */
+/**
+ * @brief Voice i of a sample, the float overloads let generic code loop over LaneCount<T> voices
+ */
+inline float &lane(float &x, int i) {
+    return x;
+}
+
+
+inline const float &lane(const float &x, int i) {
+    return x;
+}
+
+
+template<int LANES>
+inline float &lane(dsp::FloatLanes<LANES> &x, int i) {
+    return x.v[i];
+}
+
+
+template<int LANES>
+inline const float &lane(const dsp::FloatLanes<LANES> &x, int i) {
+    return x.v[i];
+}
+
+
+/**
+ * @brief Lane-wise clamp
+ */
+inline float clampLanes(float x, float min, float max) {
+    return x < min ? min : (x > max ? max : x);
+}
+
+
+template<int LANES>
+inline dsp::FloatLanes<LANES> clampLanes(dsp::FloatLanes<LANES> x, float min, float max) {
+    for (int i = 0; i < LANES; i++) {
+        x.v[i] = x.v[i] < min ? min : (x.v[i] > max ? max : x.v[i]);
+    }
+
+    return x;
+}
+
+
+/**
+ * @brief Lane-wise version of flushDenormal()
+ */
+template<int LANES>
+inline dsp::FloatLanes<LANES> flushDenormal(dsp::FloatLanes<LANES> x) {
+    for (int i = 0; i < LANES; i++) {
+        x.v[i] = fabsf(x.v[i]) < DENORMAL_THRESHOLD ? 0.f : x.v[i];
+    }
+
+    return x;
+}
+
+
+/**
+ * @brief Lane-wise version of fastatan()
+ */
+template<int LANES>
+inline dsp::FloatLanes<LANES> fastatan(const dsp::FloatLanes<LANES> &x) {
+    return x / (1.0f + 0.28f * (x * x));
+}
+
+
+/**
+ * @brief Linear fade of five points with one fade value for all lanes
+ * @param n Fade value 0..4
+ * @return
+ */
+template<int LANES>
+inline dsp::FloatLanes<LANES> fade5(const dsp::FloatLanes<LANES> &a, const dsp::FloatLanes<LANES> &b, const dsp::FloatLanes<LANES> &c,
+                               const dsp::FloatLanes<LANES> &d, const dsp::FloatLanes<LANES> &e, float n) {
+    if (n >= 0 && n < 1) {
+        return (1 - n) * a + n * b;
+    } else if (n >= 1 && n < 2) {
+        return (1 - (n - 1)) * b + (n - 1) * c;
+    } else if (n >= 2 && n < 3) {
+        return (1 - (n - 2)) * c + (n - 2) * d;
+    } else if (n >= 3 && n < 4) {
+        return (1 - (n - 3)) * d + (n - 3) * e;
+    }
+
+    return e;
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "DSPMath.hpp"
 
 
@@ -25,17 +26,6 @@ float cliph(float in, float clip) {
 }
 
 
-/**
- * @brief Wrap input number between -PI..PI
- * @param n Input number
- * @return Wrapped value
- */
-float wrapTWOPI(float n) {
-    float b = 1.f / TWOPI * n;
-    return (b - lround(b)) * TWOPI;
-}
-
-
 /**
  * @brief Get PLL increment depending on frequency
  * @param frq Frequency
@@ -47,27 +37,23 @@ float getPhaseIncrement(float frq) {
 
 
 /**
- * @brief Actual BLIT core computation
+ * @brief BLIT generator based on current phase
+ *
+ * The phase of the numerator (N - 1/2) * phase is formed in fixed point, where the product wraps
+ * by itself.
+ *
  * @param N Harmonics
- * @param phase Current phase value
+ * @param phase Current phase of the PhaseAccumulator
  * @return
  */
-float BLITcore(float N, float phase) {
-    float a = wrapTWOPI((clipl(N - 1, 0.f) + 0.5f) * phase);
-    float x = fastSin(a) * 1.f / fastSin(0.5f * phase);
-    return (x - 1.f) * 2.f;
-}
+float BLIT(int N, uint32_t phase) {
+    if (phase == 0) return 1.f;
 
+    uint32_t m = (uint32_t) std::max(N - 1, 0);
+    uint32_t a = m * phase + (uint32_t) ((int32_t) phase >> 1);
 
-/**
- * @brief BLIT generator based on current phase
- * @param N Harmonics
- * @param phase Current phase of PLL
- * @return
- */
-float BLIT(float N, float phase) {
-    if (phase == 0.f) return 1.f;
-    else return BLITcore(N, phase);
+    float x = fastSin(PhaseAccumulator::toRadians(a)) * 1.f / fastSin(0.5f * PhaseAccumulator::toRadians(phase));
+    return (x - 1.f) * 2.f;
 }
 
 
@@ -78,7 +64,7 @@ float BLIT(float N, float phase) {
  * @return
  */
 float Integrator::add(float x, float Fn) {
-    value = (x - value) * (d * Fn) + value;
+    value = flushDenormal((x - value) * (d * Fn) + value);
     return value;
 }
 
@@ -91,7 +77,7 @@ float Integrator::add(float x, float Fn) {
 double DCBlocker::filter(double x) {
     double y = x - xm1 + r * ym1;
     xm1 = x;
-    ym1 = y;
+    ym1 = flushDenormal(y);
 
     return y;
 }
@@ -1,17 +1,57 @@
 #pragma once
 
+#include <atomic>
 #include <cmath>
-#include <random>
+#include <stdint.h>
+#include <string.h>
+#if defined(__SSE__) || defined(__x86_64__)
+#include <xmmintrin.h>
+#endif
 #include "rack.hpp"
 #include "dsp/resampler.hpp"
 #include "DSPEffect.hpp"
+#include "Horner.h"
 
 #define LAMBERT_W_THRESHOLD 10e-10
+#define DENORMAL_THRESHOLD 1e-15f   // states below this level (-300dB) are flushed to zero
 using namespace rack;
 
 const static float TWOPI = (float) M_PI * 2;
 
 
+/**
+ * @brief Switch the FPU of the current thread to flush-to-zero / denormals-are-zero mode, the mode
+ *        stays set for the thread, so this is called once and not per sample
+ */
+inline void enableFlushToZero() {
+#if defined(__SSE__) || defined(__x86_64__)
+    /* FTZ (bit 15) and DAZ (bit 6) */
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+#elif defined(__aarch64__)
+    uint64_t fpcr;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+
+    /* FZ (bit 24) */
+    __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr | (1 << 24)));
+#endif
+}
+
+
+/**
+ * @brief Flush a decaying state to zero before it becomes subnormal, compiles to a compare and mask
+ * @param x State value
+ * @return x or 0 if below DENORMAL_THRESHOLD
+ */
+inline float flushDenormal(float x) {
+    return fabsf(x) < DENORMAL_THRESHOLD ? 0.f : x;
+}
+
+
+inline double flushDenormal(double x) {
+    return fabs(x) < DENORMAL_THRESHOLD ? 0. : x;
+}
+
+
 /**
  * @brief Basic leaky integrator
  */
@@ -87,17 +127,113 @@ public:
 
 
 /**
- * @brief Simple noise generator
+ * @brief Uniform noise generator with its own state per instance
+ *
+ * Four independent xorshift32 generators, the scalar call advances the first one, fill() advances
+ * all four in parallel so the loop maps to SSE integer instructions. No state is shared between
+ * instances, so modules can run on different threads.
  */
 struct Noise {
+    static const int LANES = 4;
+
+    uint32_t s[LANES];
+
+
+    /**
+     * @brief Seed each instance differently, derived from a global counter
+     */
+    Noise() {
+        static std::atomic<uint32_t> instances(0);
+        seed(instances.fetch_add(1) * LANES);
+    }
+
+
+    explicit Noise(uint32_t seed) {
+        Noise::seed(seed);
+    }
+
+
+    /**
+     * @brief Set up all generators from one seed, scrambled so neighbouring seeds give unrelated streams
+     * @param seed
+     */
+    void seed(uint32_t seed) {
+        for (int i = 0; i < LANES; i++) {
+            uint32_t x = (seed + i + 1) * 0x9E3779B9u;
+
+            x ^= x >> 16;
+            x *= 0x85EBCA6Bu;
+            x ^= x >> 13;
+            x *= 0xC2B2AE35u;
+            x ^= x >> 16;
+
+            s[i] = x != 0 ? x : 0x6D2B79F5u;    // xorshift must not start at zero
+        }
+    }
+
+
+    inline uint32_t nextInt() {
+        uint32_t x = s[0];
+
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
 
-    Noise() {}
+        return s[0] = x;
+    }
+
+
+    /**
+     * @brief Next random number
+     * @param gain Range of the result
+     * @return Uniform value in 0..gain
+     */
+    inline float nextFloat(float gain) {
+        return (float) (int32_t) (nextInt() >> 8) * (gain / 16777216.f);
+    }
+
+
+    /**
+     * @brief Fill a block with uniform noise, the block is produced by all generators in parallel
+     * @param out Output samples
+     * @param n Number of samples
+     * @param gain Range of the result
+     */
+    void fill(float *out, int n, float gain) {
+        uint32_t x0 = s[0], x1 = s[1], x2 = s[2], x3 = s[3];
+        float scale = gain / 16777216.f;
+        int i = 0;
+
+        for (; i + LANES <= n; i += LANES) {
+            x0 ^= x0 << 13;
+            x1 ^= x1 << 13;
+            x2 ^= x2 << 13;
+            x3 ^= x3 << 13;
+
+            x0 ^= x0 >> 17;
+            x1 ^= x1 >> 17;
+            x2 ^= x2 >> 17;
+            x3 ^= x3 >> 17;
+
+            x0 ^= x0 << 5;
+            x1 ^= x1 << 5;
+            x2 ^= x2 << 5;
+            x3 ^= x3 << 5;
+
+            out[i] = (float) (int32_t) (x0 >> 8) * scale;
+            out[i + 1] = (float) (int32_t) (x1 >> 8) * scale;
+            out[i + 2] = (float) (int32_t) (x2 >> 8) * scale;
+            out[i + 3] = (float) (int32_t) (x3 >> 8) * scale;
+        }
 
+        s[0] = x0;
+        s[1] = x1;
+        s[2] = x2;
+        s[3] = x3;
 
-    float nextFloat(float gain) {
-        static std::default_random_engine e;
-        static std::uniform_real_distribution<> dis(0, 1); // rage 0 - 1
-        return (float) dis(e) * gain;
+        for (; i < n; i++) {
+            out[i] = nextFloat(gain);
+        }
     }
 };
 
@@ -191,7 +327,80 @@ inline float fastSin(float angle) {
 }
 
 
-float wrapTWOPI(float n);
+/**
+ * @brief Phase accumulator in 32 bit fixed point, one cycle spans the whole integer range
+ *
+ * The wrap is the unsigned overflow, so advancing costs a single add, needs no branch or rounding
+ * and the phase never drifts. Read as signed integer the phase maps to -PI..PI, which is the input
+ * range of fastSin().
+ */
+struct PhaseAccumulator {
+    uint32_t phase = 0;
+    uint32_t incr = 0;
+
+
+    /**
+     * @brief Convert a fixed point phase to radians
+     * @param phase
+     * @return Angle in -PI..PI
+     */
+    static inline float toRadians(uint32_t phase) {
+        return (float) (int32_t) phase * (TWOPI / 4294967296.f);
+    }
+
+
+    /**
+     * @brief Convert radians to a fixed point phase, any angle is wrapped
+     * @param rad
+     * @return
+     */
+    static inline uint32_t fromRadians(float rad) {
+        return (uint32_t) (int64_t) ((double) rad * (4294967296. / TWOPI));
+    }
+
+
+    /**
+     * @brief Set the phase increment per sample
+     * @param rad Increment in radians
+     */
+    void setIncrement(float rad) {
+        incr = fromRadians(rad);
+    }
+
+
+    void setRadians(float rad) {
+        phase = fromRadians(rad);
+    }
+
+
+    inline float getRadians() const {
+        return toRadians(phase);
+    }
+
+
+    /**
+     * @brief Advance by one sample
+     * @return New phase
+     */
+    inline uint32_t next() {
+        return phase += incr;
+    }
+
+
+    /**
+     * @brief Check if the last call of next() passed from PI to -PI
+     * @return
+     */
+    inline bool wrapped() const {
+        return phase + 0x80000000u < incr;
+    }
+
+
+    void reset() {
+        phase = 0;
+    }
+};
+
 
 float getPhaseIncrement(float frq);
 
@@ -199,7 +408,7 @@ float clipl(float in, float clip);
 
 float cliph(float in, float clip);
 
-float BLIT(float N, float phase);
+float BLIT(int N, uint32_t phase);
 
 float shape1(float a, float x);
 
@@ -488,6 +697,96 @@ inline double erf(const double x) {
 }
 
 
+/**
+ * @brief Range reduction and Pade approximant of e^x for x <= 0, e^x = scale * num / den
+ *
+ * The [6/6] approximant of Cephes on |r| <= ln(2)/2, the caller does the division, so it can
+ * be fused with a following one. Arguments below -700 are clamped, so scale stays normal.
+ *
+ * @param x
+ * @param scale Power of two
+ * @param num Numerator
+ * @param den Denominator
+ */
+inline void fastexpPade(double x, double &scale, double &num, double &den) {
+    x = x < -700. ? -700. : x;
+
+    /* x = k * ln(2) + r, ln(2) is split so k * 6.93145751953125e-1 is exact */
+    int32_t k = (int32_t) (x * M_LOG2E - 0.5);
+    double r = x - k * 6.93145751953125e-1 - k * 1.42860682030941723212e-6;
+    double r2 = r * r;
+
+    double p = r * HORNER2(double, r2, 1.26177193074810590878e-4, 3.02994407707441961300e-2, 9.99999999999999999910e-1);
+    double q = HORNER3(double, r2, 3.00198505138664455042e-6, 2.52448340349684104192e-3, 2.27265548208155028766e-1,
+                       2.00000000000000000009e0);
+
+    num = q + p;
+    den = q - p;
+
+    /* 2^k in the exponent field, k + 1023 is positive so zero extension suffices and vectorizes */
+    int64_t e = (int64_t) (uint32_t) (k + 1023) << 52;
+    memcpy(&scale, &e, sizeof(scale));
+}
+
+
+/**
+ * @brief e^x for x <= 0 in double precision, relative error below 5e-15 for x > -40, growing to
+ *        1e-13 at -700 when the compiler merges the split of ln(2)
+ * @param x
+ * @return
+ */
+inline double fastexp(double x) {
+    double scale, num, den;
+    fastexpPade(x, scale, num, den);
+
+    return scale * num / den;
+}
+
+
+/**
+ * @brief log(cosh(x)) without overflow, computed as |x| - ln(2) + log1p(e^(-2|x|)).
+ *        Absolute error below 2e-15 * (1 + |x|), finite for all finite x.
+ * @param x
+ * @return
+ */
+inline double logcosh(double x) {
+    double a = fabs(x);
+    double scale, num, den;
+    fastexpPade(-2. * a, scale, num, den);
+
+    /* log1p(u) = 2 * atanh(s) with s = u / (2 + u) in 0..1/3, both divisions fused into one */
+    num *= scale;
+    double s = num / (2. * den + num);
+    double s2 = s * s;
+    double s4 = s2 * s2;
+    double s8 = s4 * s4;
+
+    /* atanh(s) / s in Estrin's scheme, which shortens the dependency chain of Horner's */
+    double p = (1.00000000000000094e+00 + 3.33333333331274726e-01 * s2) +
+               (2.00000000531485940e-01 + 1.42857092431298154e-01 * s2) * s4 +
+               ((1.11113464758438165e-01 + 9.08481152935777500e-02 * s2) +
+                (7.78394149070083234e-02 + 5.87979602363315707e-02 * s2) * s4) * s8 +
+               9.36346017854905871e-02 * s8 * s8;
+
+    double l = 2. * s * p;
+
+    return (l - M_LN2) + a;
+}
+
+
+/**
+ * @brief Block version of logcosh(), the loop has no library calls and vectorizes
+ * @param x Input
+ * @param y Output, may be the same as x
+ * @param n Number of samples
+ */
+inline void logcoshBlock(const double *x, double *y, int n) {
+    for (int i = 0; i < n; i++) {
+        y[i] = logcosh(x[i]);
+    }
+}
+
+
 /**
  * @brief Approximates log to the base of 2 with optimized code.
  * @brief https://www.ebayinc.com/stories/blogs/tech/fast-approximate-logarithms-part-i-the-basics/
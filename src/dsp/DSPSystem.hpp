@@ -1,6 +1,11 @@
 #pragma once
+
+#include <string.h>
+#include <math.h>
+
 #define DEFAULT_SR 44100.0f
 #define TRIGGER_PROCESSING true
+#define DSP_CONTROL_BLOCK 16
 
 /**
  * @brief Basic DSP types
@@ -16,11 +21,62 @@ struct DSPPort {
 };
 
 
+/**
+ * @brief Smoothing of control rate parameters
+ */
+enum DSPSmoothing {
+    SMOOTH_NONE,    // jump to the new value at the next control block
+    SMOOTH_LINEAR,  // linear ramp over the smoothing time
+    SMOOTH_ONEPOLE  // exponential approach, time is the time constant
+};
+
+
 /**
  * @brief Represents a parameter of a DSP system
+ *
+ * Parameters are audio rate by default: every change triggers invalidate() right away. Control
+ * rate parameters only mark the system dirty and are picked up (and smoothed) once per control
+ * block of DSP_CONTROL_BLOCK samples.
  */
 struct DSPParam {
-    float value;
+    float value = 0;        // current value, seen by invalidate()
+    float target = 0;       // value set by setParam()
+    float delta = 0;        // increment per control block of a linear ramp
+    int steps = 0;          // control blocks left of a linear ramp
+    float coef = 1;         // one-pole coefficient per control block
+    float time = 0;         // smoothing time in seconds
+    DSPSmoothing smoothing = SMOOTH_NONE;
+    bool controlRate = false;
+
+
+    /**
+     * @brief Advance the smoothing by one control block
+     * @return True if the value has changed
+     */
+    bool advance() {
+        if (value == target) return false;
+
+        switch (smoothing) {
+            case SMOOTH_LINEAR:
+                if (--steps > 0) {
+                    value += delta;
+                    break;
+                }
+
+                value = target;
+                break;
+            case SMOOTH_ONEPOLE:
+                value += (target - value) * coef;
+
+                if (fabsf(target - value) < 1e-6f) value = target;
+                break;
+            default:
+                value = target;
+                break;
+        }
+
+        return true;
+    }
 };
 
 
@@ -54,6 +110,8 @@ protected:
     DSPParam param[NUM_PARAM] = {};
 
     float sr;
+    int controlCounter = 0;
+    bool dirty = false;
 
 public:
 
@@ -78,26 +136,109 @@ public:
          */
     void updateSampleRate(float sr) {
         DSPSystem::sr = sr;
+
+        for (int i = 0; i < NUM_PARAM; i++) {
+            updateSmoothing(i);
+        }
+
         invalidate();
     }
 
 
     /**
      * @brief Update a parameter of the system
+     *
+     * Audio rate parameters trigger invalidate() at once, control rate parameters only mark
+     * the system dirty and start their smoothing, see updateParams().
+     *
      * @param id Parameter ID
      * @param value Value
      * @param trigger Trigger call of invalidate() - use false to supress
      */
     void setParam(int id, float value, bool trigger = true) {
-        if (param[id].value != value) {
-            param[id].value = value;
+        DSPParam &p = param[id];
+
+        if (p.target == value) return;
+
+        p.target = value;
+
+        if (!p.controlRate) {
+            p.value = value;
 
             /* setup of new parameter triggers invalidation per default */
             if (trigger) {
                 invalidate();
             }
+
+            return;
+        }
+
+        if (p.smoothing == SMOOTH_LINEAR) {
+            p.steps = (int) (p.time * sr / DSP_CONTROL_BLOCK) + 1;
+            p.delta = (value - p.value) / p.steps;
         }
 
+        dirty = dirty || trigger;
+    }
+
+
+    /**
+     * @brief Move a parameter to the control rate and set up its smoothing
+     * @param id Parameter ID
+     * @param smoothing Smoothing type
+     * @param time Ramp time or time constant in seconds
+     */
+    void setControlRate(int id, DSPSmoothing smoothing = SMOOTH_NONE, float time = 0.f) {
+        DSPParam &p = param[id];
+
+        p.controlRate = true;
+        p.smoothing = smoothing;
+        p.time = time;
+
+        updateSmoothing(id);
+    }
+
+
+    /**
+     * @brief Switch a parameter back to audio rate, every change is applied at once
+     * @param id Parameter ID
+     */
+    void setAudioRate(int id) {
+        param[id].controlRate = false;
+        param[id].value = param[id].target;
+    }
+
+
+    /**
+     * @brief Advance the parameter layer, to be called by the system once per sample
+     *
+     * Once per control block the smoothed parameters take their next step, and invalidate() is
+     * called if any of them has changed.
+     *
+     * @param n Number of samples processed since the last call
+     * @return True if invalidate() has been called
+     */
+    inline bool updateParams(int n = 1) {
+        controlCounter -= n;
+
+        if (controlCounter > 0) return false;
+
+        controlCounter += DSP_CONTROL_BLOCK;
+
+        bool changed = dirty;
+        dirty = false;
+
+        for (int i = 0; i < NUM_PARAM; i++) {
+            if (param[i].controlRate && param[i].advance()) {
+                changed = true;
+            }
+        }
+
+        if (changed) {
+            invalidate();
+        }
+
+        return changed;
     }
 
 
@@ -146,6 +287,44 @@ public:
      * @return
      */
     virtual void process() {};
+
+protected:
+
+    /**
+     * @brief Derive the one-pole coefficient of a parameter from its time and the sample rate
+     * @param id Parameter ID
+     */
+    void updateSmoothing(int id) {
+        DSPParam &p = param[id];
+
+        if (p.smoothing != SMOOTH_ONEPOLE || p.time <= 0.f) {
+            p.coef = 1.f;
+            return;
+        }
+
+        p.coef = 1.f - expf(-DSP_CONTROL_BLOCK / (p.time * sr));
+    }
+
+public:
+
+    /**
+     * @brief Process a block of samples, parameters are held for the whole block
+     *
+     * The default feeds the first input and reads the first output once per sample. Systems
+     * override this with a loop which keeps their state in locals.
+     *
+     * @param in Input samples, ignored by systems without inputs
+     * @param out Output samples
+     * @param n Number of samples
+     */
+    virtual void processBlock(const float *in, float *out, int n) {
+        for (int i = 0; i < n; i++) {
+            if (NUM_IN > 0) input[0].value = in[i];
+
+            process();
+            out[i] = output[0].value;
+        }
+    }
 };
 
 
@@ -252,39 +431,353 @@ struct DSPSystem2x2 : DSPSystem<2, 2, 0> {
 };
 
 
+/**
+ * @brief Statically dispatched signal processor for small building blocks
+ *
+ * Same interface as DSPSystem, but process() and invalidate() of the derived class are
+ * resolved at compile time (CRTP), so chains of blocks inline completely into the inner
+ * loop of the owner. The derived class hides process() and invalidate() instead of
+ * overriding them.
+ *
+ * @tparam DERIVED Implementing class
+ */
+template<typename DERIVED, int NUM_IN, int NUM_OUT, int NUM_PARAM>
+struct DSPStaticSystem {
+
+protected:
+    DSPPort input[NUM_IN] = {};
+    DSPPort output[NUM_OUT] = {};
+    DSPParam param[NUM_PARAM] = {};
+
+    float sr;
+
+
+    inline DERIVED &derived() {
+        return *static_cast<DERIVED *>(this);
+    }
+
+public:
+
+    DSPStaticSystem() {
+        sr = DEFAULT_SR;
+    }
+
+
+    explicit DSPStaticSystem(float sr) : sr(sr) {}
+
+
+    /**
+     * @brief Update sample rate on change
+     * @param sr
+     */
+    void updateSampleRate(float sr) {
+        DSPStaticSystem::sr = sr;
+        derived().invalidate();
+    }
+
+
+    /**
+     * @brief Update a parameter of the system
+     * @param id Parameter ID
+     * @param value Value
+     * @param trigger Trigger call of invalidate() - use false to supress
+     */
+    void setParam(int id, float value, bool trigger = true) {
+        if (param[id].value != value) {
+            param[id].value = value;
+
+            if (trigger) {
+                derived().invalidate();
+            }
+        }
+    }
+
+
+    float getParam(int id) {
+        return param[id].value;
+    }
+
+
+    inline float getOutput(int id) {
+        return output[id].value;
+    }
+
+
+    /**
+     * @brief Set input port to new value
+     * @param id Port ID
+     * @param value
+     */
+    inline void setInput(int id, float value, bool proccess = false) {
+        input[id].value = value;
+
+        if (proccess) {
+            derived().process();
+        }
+    }
+
+
+    void invalidate() {}
+
+
+    void process() {}
+
+
+    /**
+     * @brief Process a block of samples through the first input and output
+     * @param in Input samples, ignored by systems without inputs
+     * @param out Output samples
+     * @param n Number of samples
+     */
+    void processBlock(const float *in, float *out, int n) {
+        for (int i = 0; i < n; i++) {
+            if (NUM_IN > 0) input[0].value = in[i];
+
+            derived().process();
+            out[i] = output[0].value;
+        }
+    }
+};
+
+
+/**
+ * @brief Statically dispatched 1 in and 1 out system
+ */
+template<typename DERIVED>
+struct DSPStaticSystem1x1 : DSPStaticSystem<DERIVED, 1, 1, 0> {
+    enum Inputs {
+        IN
+    };
+
+    enum Outputs {
+        OUT
+    };
+
+
+    inline float get() {
+        return this->output[OUT].value;
+    }
+
+
+    inline void set(float value) {
+        this->setInput(IN, value, TRIGGER_PROCESSING);
+    }
+};
+
+
+/**
+ * @brief Statically dispatched 2 in and 1 out system
+ */
+template<typename DERIVED>
+struct DSPStaticSystem2x1 : DSPStaticSystem<DERIVED, 2, 1, 0> {
+    enum Inputs {
+        IN1,
+        IN2
+    };
+
+    enum Outputs {
+        OUT
+    };
+
+
+    inline float get() {
+        return this->output[OUT].value;
+    }
+
+
+    inline void set(float in1, float in2, bool proccess = true) {
+        this->setInput(IN1, in1);
+        this->setInput(IN2, in2, proccess);
+    }
+};
+
+
+/**
+ * @brief Statically dispatched 2 in and 2 out system
+ */
+template<typename DERIVED>
+struct DSPStaticSystem2x2 : DSPStaticSystem<DERIVED, 2, 2, 0> {
+    enum Inputs {
+        IN1,
+        IN2
+    };
+
+    enum Outputs {
+        OUT1,
+        OUT2
+    };
+
+
+    inline float get(int out = 0) {
+        return this->output[out].value;
+    }
+
+
+    inline void set(float in1, float in2, bool process = true) {
+        this->setInput(IN1, in1);
+        this->setInput(IN2, in2, process);
+    }
+};
+
+
+/**
+ * @brief Smallest power of two which holds a given number of samples
+ * @param size
+ * @param length Used for the recursion
+ * @return
+ */
+constexpr int delayLength(int size, int length = 1) {
+    return length >= size ? length : delayLength(size, length * 2);
+}
+
+
 /**
  * @brief Delayed signal model
- * @tparam SIZE
+ *
+ * Power of two ring buffer: writing a sample costs one store and one mask, independent of the
+ * length. process() keeps the classic behaviour and outputs the input delayed by SIZE - 1
+ * samples. Taps can be read at any integer or fractional position up to the length, which
+ * makes the line usable for combs, chorus or Karplus-Strong voices.
+ *
+ * @tparam SIZE Number of samples held by the line
  */
 template<int SIZE>
-struct DSPDelay : DSPSystem1x1 {
+struct DSPDelay : DSPStaticSystem1x1<DSPDelay<SIZE>> {
+    using DSPStaticSystem1x1<DSPDelay<SIZE>>::IN;
+    using DSPStaticSystem1x1<DSPDelay<SIZE>>::OUT;
+
+    static const int LENGTH = delayLength(SIZE);
+    static const int MASK = LENGTH - 1;
 
 private:
-    float buffer[SIZE] = {};
+    float buffer[LENGTH] = {};
+    int pos = 0;        // index of the newest sample
+    float ap = 0;       // last output of the allpass tap
 
+public:
 
     /**
-     * @brief Shift left all elements
+     * @brief Clear the line
      */
-    void shift() {
-        for (int i = 0; i < SIZE - 1; i++) {
-            buffer[i] = buffer[i + 1];
+    void reset() {
+        for (int i = 0; i < LENGTH; i++) {
+            buffer[i] = 0;
         }
+
+        ap = 0;
     }
 
 
-public:
+    /**
+     * @brief Add the next sample
+     * @param x
+     */
+    inline void write(float x) {
+        pos = (pos + 1) & MASK;
+        buffer[pos] = x;
+    }
+
+
+    /**
+     * @brief Add a block of samples, copied in at most two contiguous runs
+     * @param x Samples, oldest first
+     * @param n Number of samples, at most LENGTH
+     */
+    void writeBlock(const float *x, int n) {
+        int start = (pos + 1) & MASK;
+        int first = n < LENGTH - start ? n : LENGTH - start;
+
+        memcpy(&buffer[start], x, first * sizeof(float));
+        memcpy(buffer, &x[first], (n - first) * sizeof(float));
+
+        pos = (pos + n) & MASK;
+    }
+
+
+    /**
+     * @brief Read a sample at an integer delay
+     * @param delay 0 is the newest sample, up to LENGTH - 1
+     * @return
+     */
+    inline float read(int delay) const {
+        return buffer[(pos - delay) & MASK];
+    }
+
+
+    /**
+     * @brief Read at a fractional delay with linear interpolation
+     * @param delay 0 .. LENGTH - 2
+     * @return
+     */
+    inline float readLinear(float delay) const {
+        int d = (int) delay;
+        float t = delay - d;
+
+        float x0 = read(d);
+        float x1 = read(d + 1);
+
+        return x0 + t * (x1 - x0);
+    }
+
+
+    /**
+     * @brief Read at a fractional delay with 4-point cubic Hermite interpolation
+     * @param delay 1 .. LENGTH - 3, shorter delays are clamped to 1 as the newer neighbour is missing
+     * @return
+     */
+    inline float readCubic(float delay) const {
+        /* below 1 the point before the newest sample would wrap around to the oldest one */
+        if (delay < 1.f) delay = 1.f;
+
+        int d = (int) delay;
+        float t = delay - d;
+
+        float xm1 = read(d - 1);
+        float x0 = read(d);
+        float x1 = read(d + 1);
+        float x2 = read(d + 2);
+
+        float c1 = 0.5f * (x1 - xm1);
+        float c2 = xm1 - 2.5f * x0 + 2.f * x1 - 0.5f * x2;
+        float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+
+        return ((c3 * t + c2) * t + c1) * t + x0;
+    }
+
+
+    /**
+     * @brief Read at a fractional delay with a first order allpass
+     *
+     * Flat magnitude response, which keeps the loop gain of feedback delays (Karplus-Strong,
+     * combs) independent of the fraction. The allpass has state, so it serves one tap which is
+     * read exactly once per written sample, and the delay should only move slowly.
+     *
+     * @param delay 0 .. LENGTH - 2
+     * @return
+     */
+    inline float readAllpass(float delay) {
+        int d = (int) delay;
+        float t = delay - d;
+
+        /* keep the coefficient away from the pole at t = 0 */
+        if (t < 0.1f && d > 0) {
+            d--;
+            t += 1.f;
+        }
+
+        float eta = (1.f - t) / (1.f + t);
+        ap = eta * read(d) + read(d + 1) - eta * ap;
+
+        return ap;
+    }
+
 
     /**
      * @brief Proccess the Delay
      */
-    void process() override {
-        /* shift all elements left */
-        shift();
-        /* set last element to current input */
-        buffer[SIZE - 1] = input[IN].value;
-        /* set output */
-        output[OUT].value = buffer[0];
+    inline void process() {
+        write(this->input[IN].value);
+        this->output[OUT].value = read(SIZE - 1);
     }
 };
 
@@ -293,4 +786,4 @@ public:
  * @brief Shortcut for a classic z^-1 delay (1-Sample)
  */
 typedef DSPDelay<1> DSPDelay1;
-}
\ No newline at end of file
+}
@@ -0,0 +1,359 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "DSPLanes.hpp"
+#include "Horner.h"
+
+/*
+ * Approximations of the transcendental functions for float and FloatLanes<N>.
+ *
+ * All functions are written once as templates over a small set of primitives below. The primitives
+ * are overloaded for float and for FloatLanes<N>, where they are fixed size loops without branches,
+ * so the whole function compiles to straight SSE2 (4 lanes) or AVX2 (8 lanes) code. The error bounds
+ * are measured against the double precision libm over the stated range.
+ */
+
+
+/**
+ * @brief Reinterpret the bits of a float
+ */
+inline int32_t vmBits(float x) {
+    int32_t i;
+    memcpy(&i, &x, sizeof(i));
+    return i;
+}
+
+
+inline float vmFloat(int32_t i) {
+    float x;
+    memcpy(&x, &i, sizeof(x));
+    return x;
+}
+
+
+/**
+ * @brief Round to the nearest integer, halfway cases away from zero, for |x| < 2^31
+ */
+inline float vmRound(float x) {
+    return (float) (int32_t) (x + (x < 0 ? -0.5f : 0.5f));
+}
+
+
+/**
+ * @brief 2^n for an integral n in -126..127, assembled in the exponent field
+ */
+inline float vmPow2i(float n) {
+    return vmFloat(((int32_t) n + 127) << 23);
+}
+
+
+/**
+ * @brief Split a positive normal float into exponent and mantissa in [1, 2)
+ */
+inline float vmFrexp(float x, float &e) {
+    int32_t i = vmBits(x);
+
+    e = (float) ((i >> 23) - 127);
+    return vmFloat((i & 0x007FFFFF) | 0x3F800000);
+}
+
+
+inline float vmMin(float a, float b) {
+    return a < b ? a : b;
+}
+
+
+inline float vmMax(float a, float b) {
+    return a > b ? a : b;
+}
+
+
+inline float vmAbs(float x) {
+    return vmFloat(vmBits(x) & 0x7FFFFFFF);
+}
+
+
+/**
+ * @brief Give a the sign of b
+ */
+inline float vmCopySign(float a, float b) {
+    return vmFloat((vmBits(a) & 0x7FFFFFFF) | (vmBits(b) & (int32_t) 0x80000000));
+}
+
+
+/**
+ * @brief Lane-wise c < d ? a : b
+ */
+inline float vmSelectLess(float c, float d, float a, float b) {
+    return c < d ? a : b;
+}
+
+
+/**
+ * @brief Value barrier, keeps -funsafe-math-optimizations of the Rack build from merging the two
+ *        parts of the pi reduction in vsin() and vcos() into one rounded constant
+ */
+inline float vmKeep(float x) {
+#if defined(__GNUC__) && (defined(__SSE__) || defined(__x86_64__))
+    __asm__("" : "+x"(x));
+#elif defined(__GNUC__) && defined(__aarch64__)
+    __asm__("" : "+w"(x));
+#endif
+    return x;
+}
+
+
+template<int LANES>
+inline const dsp::FloatLanes<LANES> &vmKeep(const dsp::FloatLanes<LANES> &x) {
+    /* the lane loops are not merged across operators, checked with the Rack flags */
+    return x;
+}
+
+
+template<int LANES>
+inline dsp::FloatLanes<LANES> vmRound(const dsp::FloatLanes<LANES> &x) {
+    dsp::FloatLanes<LANES> r;
+    for (int i = 0; i < LANES; i++) r.v[i] = vmRound(x.v[i]);
+    return r;
+}
+
+
+template<int LANES>
+inline dsp::FloatLanes<LANES> vmPow2i(const dsp::FloatLanes<LANES> &n) {
+    dsp::FloatLanes<LANES> r;
+    for (int i = 0; i < LANES; i++) r.v[i] = vmPow2i(n.v[i]);
+    return r;
+}
+
+
+template<int LANES>
+inline dsp::FloatLanes<LANES> vmFrexp(const dsp::FloatLanes<LANES> &x, dsp::FloatLanes<LANES> &e) {
+    dsp::FloatLanes<LANES> r;
+    for (int i = 0; i < LANES; i++) r.v[i] = vmFrexp(x.v[i], e.v[i]);
+    return r;
+}
+
+
+template<int LANES>
+inline dsp::FloatLanes<LANES> vmMin(const dsp::FloatLanes<LANES> &a, const dsp::FloatLanes<LANES> &b) {
+    dsp::FloatLanes<LANES> r;
+    for (int i = 0; i < LANES; i++) r.v[i] = vmMin(a.v[i], b.v[i]);
+    return r;
+}
+
+
+template<int LANES>
+inline dsp::FloatLanes<LANES> vmMax(const dsp::FloatLanes<LANES> &a, const dsp::FloatLanes<LANES> &b) {
+    dsp::FloatLanes<LANES> r;
+    for (int i = 0; i < LANES; i++) r.v[i] = vmMax(a.v[i], b.v[i]);
+    return r;
+}
+
+
+template<int LANES>
+inline dsp::FloatLanes<LANES> vmAbs(const dsp::FloatLanes<LANES> &x) {
+    dsp::FloatLanes<LANES> r;
+    for (int i = 0; i < LANES; i++) r.v[i] = vmAbs(x.v[i]);
+    return r;
+}
+
+
+template<int LANES>
+inline dsp::FloatLanes<LANES> vmCopySign(const dsp::FloatLanes<LANES> &a, const dsp::FloatLanes<LANES> &b) {
+    dsp::FloatLanes<LANES> r;
+    for (int i = 0; i < LANES; i++) r.v[i] = vmCopySign(a.v[i], b.v[i]);
+    return r;
+}
+
+
+template<int LANES>
+inline dsp::FloatLanes<LANES> vmSelectLess(const dsp::FloatLanes<LANES> &c, const dsp::FloatLanes<LANES> &d,
+                                           const dsp::FloatLanes<LANES> &a, const dsp::FloatLanes<LANES> &b) {
+    dsp::FloatLanes<LANES> r;
+    for (int i = 0; i < LANES; i++) r.v[i] = vmSelectLess(c.v[i], d.v[i], a.v[i], b.v[i]);
+    return r;
+}
+
+
+/**
+ * @brief 2^x, relative error below 3e-7, the argument is clamped to -126..127
+ * @param x
+ * @return
+ */
+template<typename T>
+inline T vexp2(T x) {
+    x = vmMax(vmMin(x, T(127.f)), T(-126.f));
+
+    T n = vmRound(x);
+    T f = x - n;    // -0.5..0.5
+
+    T p = HORNER5(T, f, 1.339086337e-03, 9.676031918e-03, 5.550357114e-02, 2.402210749e-01, 6.931471880e-01, 1.000000075e+00);
+
+    return p * vmPow2i(n);
+}
+
+
+/**
+ * @brief log2(x) for positive normal x, error below 4e-7 plus one ulp of the result
+ * @param x
+ * @return
+ */
+template<typename T>
+inline T vlog2(T x) {
+    T e;
+    T m = vmFrexp(x, e);
+
+    /* move the mantissa to sqrt(0.5)..sqrt(2), so the series below converges fast */
+    T big = vmSelectLess(T((float) M_SQRT2), m, T(1.f), T(0.f));
+    m = m * (1.f - 0.5f * big);
+    e = e + big;
+
+    /* log2(m) = 2/ln(2) * atanh(s) with |s| < 0.172 */
+    T s = (m - 1.f) / (m + 1.f);
+    T s2 = s * s;
+
+    return e + s * HORNER3(T, s2, 2. / 7. / M_LN2, 2. / 5. / M_LN2, 2. / 3. / M_LN2, 2. / M_LN2);
+}
+
+
+/**
+ * @brief e^x, relative error below 7e-7 for |x| < 8 and 4e-6 for |x| < 87, the error comes from
+ *        rounding x * log2(e) to float
+ */
+template<typename T>
+inline T vexp(T x) {
+    return vexp2(x * (float) M_LOG2E);
+}
+
+
+/**
+ * @brief Natural logarithm for positive normal x, error below 3e-7 plus one ulp of the result
+ */
+template<typename T>
+inline T vlog(T x) {
+    return vlog2(x) * (float) M_LN2;
+}
+
+
+/**
+ * @brief Power of a positive base, relative error below 1e-6 * |y * log2(base)|
+ * @param base
+ * @param y Exponent
+ * @return
+ */
+template<typename T>
+inline T vpow(float base, T y) {
+    return vexp2(y * log2f(base));
+}
+
+
+/**
+ * @brief Hyperbolic tangent, absolute error below 4e-7
+ *
+ * 13/6 rational minimax approximation on the clamped argument, as used by Eigen.
+ *
+ * @param x
+ * @return
+ */
+template<typename T>
+inline T vtanh(T x) {
+    x = vmMax(vmMin(x, T(7.90531110763549805f)), T(-7.90531110763549805f));
+
+    T x2 = x * x;
+    T p = x * HORNER6(T, x2, -2.76076847742355e-16, 2.00018790482477e-13, -8.60467152213735e-11,
+                      5.12229709037114e-08, 1.48572235717979e-05, 6.37261928875436e-04, 4.89352455891786e-03);
+    T q = HORNER3(T, x2, 1.19825839466702e-06, 1.18534705686654e-04, 2.26843463243900e-03, 4.89352518554385e-03);
+
+    return p / q;
+}
+
+
+/**
+ * @brief Odd polynomial of fastSin() on -pi/2..pi/2, shared by vsin() and vcos()
+ */
+template<typename T>
+inline T vsinPoly(T r) {
+    T r2 = r * r;
+
+    return r * HORNER5(T, r2, -2.39e-08, 2.7526e-06, -1.98409e-04, 8.3333315e-03, -1.666666664e-01, 1.);
+}
+
+
+/**
+ * @brief Sine, absolute error below 2e-7 for |x| < 10 and 2e-6 for |x| < 1e5
+ *
+ * The argument is reduced by multiples of pi in two parts, then the odd polynomial of fastSin()
+ * is applied on -pi/2..pi/2.
+ *
+ * @param x
+ * @return
+ */
+template<typename T>
+inline T vsin(T x) {
+    T q = vmRound(x * (float) M_1_PI);
+    T r = vmKeep(x - q * 3.140625f) - q * 9.67653589793e-4f;
+
+    /* odd multiples of pi flip the sign */
+    T h = q * 0.5f;
+    T odd = h - vmRound(h);
+    T sign = 1.f - 4.f * vmAbs(odd);
+
+    return sign * vsinPoly(r);
+}
+
+
+/**
+ * @brief Cosine, absolute error below 2e-7 for |x| < 10 and 2e-6 for |x| < 1e5 as vsin()
+ *
+ * Reduced by (k + 1/2) * pi in the same two parts as vsin(), as cos(x) = -(-1)^k * sin(r), so
+ * the quarter period is not added to x in float first.
+ *
+ * @param x
+ * @return
+ */
+template<typename T>
+inline T vcos(T x) {
+    T k = vmRound(x * (float) M_1_PI - 0.5f);
+    T q = k + 0.5f;
+    T r = vmKeep(x - q * 3.140625f) - q * 9.67653589793e-4f;
+
+    /* even k flip the sign */
+    T h = k * 0.5f;
+    T odd = h - vmRound(h);
+    T sign = 4.f * vmAbs(odd) - 1.f;
+
+    return sign * vsinPoly(r);
+}
+
+
+/**
+ * @brief Tangent for |x| < 1.5, relative error below 3e-6, meant for prewarping filter coefficients
+ */
+template<typename T>
+inline T vtan(T x) {
+    return vsin(x) / vcos(x);
+}
+
+
+/**
+ * @brief Arc tangent, absolute error below 2e-7
+ *
+ * Abramowitz & Stegun 4.4.49 on 0..1, larger arguments use atan(x) = pi/2 - atan(1/x).
+ *
+ * @param x
+ * @return
+ */
+template<typename T>
+inline T vatan(T x) {
+    T a = vmAbs(x);
+    T t = vmMin(a, 1.f / a);
+    T t2 = t * t;
+
+    T r = t * HORNER8(T, t2, 0.0028662257, -0.0161657367, 0.0429096138, -0.0752896400, 0.1065626393,
+                      -0.1420889944, 0.1999355085, -0.3333314528, 1.);
+
+    r = vmSelectLess(T(1.f), a, (float) M_PI_2 - r, r);
+
+    return vmCopySign(r, x);
+}
@@ -1,226 +1,288 @@
+#include <algorithm>
 #include "DiodeLadder.hpp"
 
-using namespace dsp;
+namespace dsp {
 
 
-DiodeLadderStage::DiodeLadderStage(float sr) : DSPEffect(sr) {
-
-}
+template<typename T>
+BasicDiodeLadderFilter<T>::BasicDiodeLadderFilter(float sr) :
+        DSPEffect(sr), rs(OVERSAMPLE, 4, UPSAMPLE_POLYPHASE, DOWNSAMPLE_HALFBAND, RS_ANY_FACTOR) {
+    fc = 0.f;
+    gamma = 0.f;
+    gammaTarget = 0.f;
+    glide = 0;
+    k = 0.f;
+    saturation = 1.f;
 
+    for (int i = 0; i < STAGES; i++) {
+        sg[i] = 0.f;
+        sgTarget[i] = 0.f;
+    }
 
-void DiodeLadderStage::init() {
-    alpha = 1.f;
-    beta = -1.f;
-    gamma = 1.f;
-    delta = 0.f;
-    epsilon = 1.f;
-    feedback = 0.f;
-    gain = 1.f;
+    target.gain[0] = 1.f;
+    target.gain[1] = 0.5f;
+    target.gain[2] = 0.5f;
+    target.gain[3] = 0.5f;
 
+    /* the last stage has no feedback from a following stage */
+    target.gamma[3] = 1.f;
+    target.delta[3] = 0.f;
+    target.epsilon[3] = 0.f;
 
-    resetZ1();
+    init();
 }
 
 
-void DiodeLadderStage::invalidate() {
-    DSPEffect::invalidate();
+template<typename T>
+void BasicDiodeLadderFilter<T>::init() {
+    DSPEffect::init();
+    reset();
+
+    in = 0.f;
+    out = 0.f;
+    out2 = 0.f;
+
+    invalidate();
+    settle();
 }
 
 
-void DiodeLadderStage::process() {
-    float x = (in * gamma + feedback + epsilon * getFeedbackOutput());
-    float vn = (gain * x - z1) * alpha;
+/**
+ * @brief Calculate the stage coefficients for the cutoff, the filter glides to them over the
+ *        next control block
+ */
+template<typename T>
+void BasicDiodeLadderFilter<T>::invalidate() {
+    T G1, G2, G3, G4;
 
-    out = vn + z1;
+    float SR = sr * rs.getFactor();
 
-    z1 = vn + out;
-}
+    freqHz = MAX_FREQUENCY / 1000.f * vpow(1000.f, fc);
+    // freqHz = 40.f * powf(500.f, fc);
 
+    T wd = TWOPI * freqHz;
+    float Ts = 1 / SR;
+    T wa = (2 / Ts) * vtan(wd * Ts / 2);
+    T g = wa * Ts / 2;
 
-float DiodeLadderStage::getFeedbackOutput() {
-    return (z1 + feedback * delta) * beta;
-}
+    G4 = 0.5f * g / (1.0f + g);
+    G3 = 0.5f * g / (1.0f + g - 0.5f * g * G4);
+    G2 = 0.5f * g / (1.0f + g - 0.5f * g * G3);
+    G1 = g / (1.0f + g - g * G2);
+
+    gammaTarget = G4 * G3 * G2 * G1;
 
+    sgTarget[0] = G4 * G3 * G2;
+    sgTarget[1] = G4 * G3;
+    sgTarget[2] = G4;
+    sgTarget[3] = 1.0f;
 
-DiodeLadderFilter::DiodeLadderFilter(float sr) : DSPEffect(sr) {
-    lpf1 = new DiodeLadderStage(sr);
-    lpf2 = new DiodeLadderStage(sr);
-    lpf3 = new DiodeLadderStage(sr);
-    lpf4 = new DiodeLadderStage(sr);
+    for (int i = 0; i < STAGES; i++) {
+        target.alpha[i] = g / (1.0f + g);
+    }
 
-    rs = new Resampler<1>(OVERSAMPLE, 4);
+    target.beta[0] = 1.0f / (1.0f + g - g * G2);
+    target.beta[1] = 1.0f / (1.0f + g - 0.5f * g * G3);
+    target.beta[2] = 1.0f / (1.0f + g - 0.5f * g * G4);
+    target.beta[3] = 1.0f / (1.0f + g);
 
-    gamma = 0.f;
-    k = 0.f;
-    saturation = 1.f;
+    target.gamma[0] = 1.0f + G1 * G2;
+    target.gamma[1] = 1.0f + G2 * G3;
+    target.gamma[2] = 1.0f + G3 * G4;
 
-    sg1 = 0.f;
-    sg2 = 0.f;
-    sg3 = 0.f;
-    sg4 = 0.f;
+    target.delta[0] = g;
+    target.delta[1] = 0.5f * g;
+    target.delta[2] = 0.5f * g;
 
-    lpf1->gain = 1.f;
-    lpf2->gain = 0.5f;
-    lpf3->gain = 0.5f;
-    lpf4->gain = 0.5f;
+    target.epsilon[0] = G2;
+    target.epsilon[1] = G3;
+    target.epsilon[2] = G4;
 
-    lpf4->gamma = 1.f;
-    lpf4->delta = 0.f;
-    lpf4->epsilon = 0.f;
-    lpf4->setFeedback(0.f);
+    glide = DSP_CONTROL_BLOCK;
 }
 
 
-void DiodeLadderFilter::init() {
-    DSPEffect::init();
-    reset();
-    invalidate();
-}
+/**
+ * @brief Jump to the current coefficients without gliding
+ */
+template<typename T>
+void BasicDiodeLadderFilter<T>::settle() {
+    stages.settle(target);
 
+    for (int i = 0; i < STAGES; i++) {
+        sg[i] = sgTarget[i];
+    }
 
-void DiodeLadderFilter::invalidate() {
-    float G1, G2, G3, G4;
+    gamma = gammaTarget;
+    glide = 0;
+}
 
-    float SR = low ? sr : sr * OVERSAMPLE;
 
-    freqHz = MAX_FREQUENCY / 1000.f * powf(1000.f, fc);
-    // freqHz = 40.f * powf(500.f, fc);
+template<typename T>
+void BasicDiodeLadderFilter<T>::process() {
+    processBlock(&lane(in, 0), &lane(out, 0), 1);
+}
 
-    float wd = TWOPI * freqHz;
-    float T = 1 / SR;
-    float wa = (2 / T) * tanf(wd * T / 2);
-    float g = wa * T / 2;
 
-    G4 = 0.5f * g / (1.0f + g);
-    G3 = 0.5f * g / (1.0f + g - 0.5f * g * G4);
-    G2 = 0.5f * g / (1.0f + g - 0.5f * g * G3);
-    G1 = g / (1.0f + g - g * G2);
+/**
+ * @brief Run the ladder for one internal sample
+ * @param x Input sample
+ * @param r Noise sample which seeds the self-oscillation
+ * @param hp Hipass output before the saturation, which is only applied to the last sample of a block
+ * @return Lowpass output
+ */
+template<typename T>
+LANE_INLINE T BasicDiodeLadderFilter<T>::process1(const T &x, const T &r, T &hp) {
+    T fo[STAGES];
 
-    gamma = G4 * G3 * G2 * G1;
+    /* feedback outputs, each stage feeds the one before */
+    fo[3] = stages.getFeedbackOutput(3);
 
-    sg1 = G4 * G3 * G2;
-    sg2 = G4 * G3;
-    sg3 = G4;
-    sg4 = 1.0f;
+    for (int i = 2; i >= 0; i--) {
+        stages.feedback[i] = fo[i + 1];
+        fo[i] = stages.getFeedbackOutput(i);
+    }
 
-    lpf1->alpha = g / (1.0f + g);
-    lpf2->alpha = g / (1.0f + g);
-    lpf3->alpha = g / (1.0f + g);
-    lpf4->alpha = g / (1.0f + g);
+    T sigma = sg[0] * fo[0] +
+              sg[1] * fo[1] +
+              sg[2] * fo[2] +
+              sg[3] * fo[3];
 
-    lpf1->beta = 1.0f / (1.0f + g - g * G2);
-    lpf2->beta = 1.0f / (1.0f + g - 0.5f * g * G3);
-    lpf3->beta = 1.0f / (1.0f + g - 0.5f * g * G4);
-    lpf4->beta = 1.0f / (1.0f + g);
+    T y = (1.0f / fastatan(saturation)) * fastatan(saturation * x);
 
-    lpf1->gamma = 1.0f + G1 * G2;
-    lpf2->gamma = 1.0f + G2 * G3;
-    lpf3->gamma = 1.0f + G3 * G4;
+    y += r;
 
-    lpf1->delta = g;
-    lpf2->delta = 0.5f * g;
-    lpf3->delta = 0.5f * g;
+    T u = (y - k * sigma) / (1 + k * gamma);
 
-    lpf1->epsilon = G2;
-    lpf2->epsilon = G3;
-    lpf3->epsilon = G4;
-}
+    u = fastatan(u / FEEDBACK_LIMITER_GAIN) * FEEDBACK_LIMITER_GAIN; // limit feedback gain of resonance
 
+    y = u;
 
-void DiodeLadderFilter::process() {
-    if (low) {
-        process1();
-    } else {
-        process2();
+    for (int i = 0; i < STAGES; i++) {
+        y = stages.process(i, y, fo[i]);
     }
-}
 
+    hp = u - y;
 
-void DiodeLadderFilter::process1() {
-    lpf3->setFeedback(lpf4->getFeedbackOutput());
-    lpf2->setFeedback(lpf3->getFeedbackOutput());
-    lpf1->setFeedback(lpf2->getFeedbackOutput());
+    return vtanh(y);
+}
 
-    float sigma = sg1 * lpf1->getFeedbackOutput() +
-                  sg2 * lpf2->getFeedbackOutput() +
-                  sg3 * lpf3->getFeedbackOutput() +
-                  sg4 * lpf4->getFeedbackOutput();
 
-    float y = (1.0f / fastatan(saturation)) * fastatan(saturation * in);
+/**
+ * @brief Filter a block of frames, the resampler runs once per chunk instead of per sample
+ * @param in N interleaved input frames of LANES voices
+ * @param out N interleaved lowpass frames
+ * @param n Number of frames
+ */
+template<typename T>
+void BasicDiodeLadderFilter<T>::processBlock(const float *in, float *out, int n) {
+    int factor = rs.getFactor();
+    int blockSize = rs.getBlockSize();
 
-    y += noise.nextFloat(NOISE_GAIN);
+    T x, r, y;
+    T hp = 0.f;
 
-    float u = (y - k * sigma) / (1 + k * gamma);
+    /* split into chunks which fit into the resampler buffer */
+    for (int i = 0; i < n; i += blockSize) {
+        int len = std::min(blockSize, n - i);
 
-    u = fastatan(u / FEEDBACK_LIMITER_GAIN) * FEEDBACK_LIMITER_GAIN; // limit feedback gain of resonance
+        for (int j = 0; j < len * LANES; j++) {
+            frames[j] = in[i * LANES + j];
+        }
 
-    lpf1->in = u;
-    lpf1->process();
+        rs.upsampleFrames(frames, up, len);
+        noise.fill(rnd, len * factor * LANES, NOISE_GAIN);
 
-    lpf2->in = lpf1->out;
-    lpf2->process();
+        for (int j = 0, m = 0; j < len; j++) {
+            /* the coefficients glide between the control blocks */
+            if (glide > 0) {
+                float w = 1.f / glide;
 
-    lpf3->in = lpf2->out;
-    lpf3->process();
+                stages.glide(target, w);
 
-    lpf4->in = lpf3->out;
-    lpf4->process();
+                for (int l = 0; l < STAGES; l++) {
+                    sg[l] += (sgTarget[l] - sg[l]) * w;
+                }
 
-    out2 = tanh(u - lpf4->out);
-    out = tanh(lpf4->out);
-}
+                gamma += (gammaTarget - gamma) * w;
+                glide--;
+            }
+
+            for (int l = 0; l < factor; l++, m++) {
+                for (int c = 0; c < LANES; c++) {
+                    lane(x, c) = (float) up[m * LANES + c];
+                    lane(r, c) = rnd[m * LANES + c];
+                }
 
+                y = process1(x, r, hp);
 
-void DiodeLadderFilter::process2() {
-    rs->doUpsample(IN, in);
-    for (int i = 0; i < rs->getFactor(); i++) {
-        in = (float) rs->getUpsampled(IN)[i];
+                for (int c = 0; c < LANES; c++) {
+                    data[m * LANES + c] = lane(y, c);
+                }
+            }
+        }
 
-        process1();
+        rs.downsampleFrames(data, frames, len);
 
-        rs->data[IN][i] = out;
+        for (int j = 0; j < len * LANES; j++) {
+            out[i * LANES + j] = (float) frames[j];
+        }
     }
 
-    out = (float) rs->getDownsampled(IN);;
+    out2 = vtanh(hp);
 }
 
 
-void DiodeLadderFilter::setSamplerate(float sr) {
-    DSPEffect::setSamplerate(sr);
+template<typename T>
+void BasicDiodeLadderFilter<T>::setSamplerate(float sr) {
+    if (autoOversampling) {
+        rs.setFactor(resolveOversampling(RS_AUTO_FACTOR, sr, TARGET_RATE));
+    }
 
-    /* set samplerate for all submodules */
-    lpf1->setSamplerate(sr);
-    lpf2->setSamplerate(sr);
-    lpf3->setSamplerate(sr);
-    lpf4->setSamplerate(sr);
+    DSPEffect::setSamplerate(sr);
+    settle();
 }
 
 
-void DiodeLadderFilter::setFrequency(float fc) {
-    DiodeLadderFilter::fc = fc;
+template<typename T>
+void BasicDiodeLadderFilter<T>::setFrequency(const T &fc) {
+    BasicDiodeLadderFilter::fc = fc;
 }
 
 
-void DiodeLadderFilter::setResonance(float k) {
-    DiodeLadderFilter::k = k;
+template<typename T>
+void BasicDiodeLadderFilter<T>::setResonance(const T &k) {
+    BasicDiodeLadderFilter::k = k;
 }
 
 
-void DiodeLadderFilter::setIn(float in) {
-    DiodeLadderFilter::in = in;
+template<typename T>
+void BasicDiodeLadderFilter<T>::setIn(const T &in) {
+    BasicDiodeLadderFilter::in = in;
 }
 
 
-float DiodeLadderFilter::getOut() const {
+template<typename T>
+const T &BasicDiodeLadderFilter<T>::getOut() const {
     return out;
 }
 
 
-void DiodeLadderFilter::setSaturation(float saturation) {
-    DiodeLadderFilter::saturation = saturation;
+template<typename T>
+void BasicDiodeLadderFilter<T>::setSaturation(const T &saturation) {
+    BasicDiodeLadderFilter::saturation = saturation;
 }
 
 
-float DiodeLadderFilter::getOut2() const {
+template<typename T>
+const T &BasicDiodeLadderFilter<T>::getOut2() const {
     return out2;
 }
+
+
+/* the single voice filter and the SSE / AVX wide voice packs */
+template struct BasicDiodeLadderFilter<float>;
+template struct BasicDiodeLadderFilter<Float4>;
+template struct BasicDiodeLadderFilter<Float8>;
+
+}
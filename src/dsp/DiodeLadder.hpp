@@ -1,102 +1,207 @@
 #pragma once
 
+#include <algorithm>
 #include "DSPEffect.hpp"
+#include "DSPSystem.hpp"
+#include "DSPLanes.hpp"
+#include "DSPVecMath.hpp"
 #include "DSPMath.hpp"
 #include "HQTrig.hpp"
 
-static const int OVERSAMPLE = 2;
 static const int FEEDBACK_LIMITER_GAIN = 25;
 namespace dsp {
 
-struct DiodeLadderStage : DSPEffect {
-
-    float fc; // cutoff frq ????
-    float alpha, beta, gamma, delta, epsilon;
-    float gain;
-    float feedback;
-    float z1;
+/**
+ * @brief Coefficients and state of the four one-pole stages of the diode ladder
+ *
+ * Stored as one array per field in a cache line aligned block, so a single voice sample touches
+ * two cache lines and the coefficient updates run over contiguous arrays.
+ *
+ * @tparam T float or FloatLanes<N>
+ */
+template<typename T>
+struct alignas(64) DiodeLadderStages {
+    static const int STAGES = 4;
+
+    T z1[STAGES];
+    T feedback[STAGES];
+    T alpha[STAGES];
+    T beta[STAGES];
+    T gamma[STAGES];
+    T delta[STAGES];
+    T epsilon[STAGES];
+    T gain[STAGES];
+
+
+    /**
+     * @brief Reset the state, the coefficients are kept
+     */
+    void reset() {
+        for (int i = 0; i < STAGES; i++) {
+            z1[i] = 0.f;
+            feedback[i] = 0.f;
+        }
+    }
 
-    float in, out;
 
-    explicit DiodeLadderStage(float sr);
-    void init() override;
-    void invalidate() override;
-    void process() override;
+    /**
+     * @brief Copy the coefficients of another stage block, the state is kept
+     * @param target Stages holding the coefficients
+     */
+    void settle(const DiodeLadderStages &target) {
+        for (int i = 0; i < STAGES; i++) {
+            alpha[i] = target.alpha[i];
+            beta[i] = target.beta[i];
+            gamma[i] = target.gamma[i];
+            delta[i] = target.delta[i];
+            epsilon[i] = target.epsilon[i];
+            gain[i] = target.gain[i];
+        }
+    }
 
 
-    void resetZ1() {
-        z1 = 0;
+    /**
+     * @brief Move the coefficients a step towards the ones of another stage block
+     * @param target Stages holding the coefficients
+     * @param w Fraction of the remaining distance
+     */
+    void glide(const DiodeLadderStages &target, float w) {
+        for (int i = 0; i < STAGES; i++) {
+            alpha[i] += (target.alpha[i] - alpha[i]) * w;
+            beta[i] += (target.beta[i] - beta[i]) * w;
+            gamma[i] += (target.gamma[i] - gamma[i]) * w;
+            delta[i] += (target.delta[i] - delta[i]) * w;
+            epsilon[i] += (target.epsilon[i] - epsilon[i]) * w;
+        }
     }
 
 
-    float getZ1() {
-        return z1;
+    LANE_INLINE T getFeedbackOutput(int i) const {
+        return (z1[i] + feedback[i] * delta[i]) * beta[i];
     }
 
 
-    void setFeedback(float fb) {
-        feedback = fb;
-    }
+    /**
+     * @brief Run one stage
+     * @param i Stage index
+     * @param x Input sample
+     * @param fo Feedback output of the stage, computed before the call
+     * @return Stage output
+     */
+    LANE_INLINE T process(int i, const T &x, const T &fo) {
+        T vn = (gain[i] * (x * gamma[i] + feedback[i] + epsilon[i] * fo) - z1[i]) * alpha[i];
+        T out = vn + z1[i];
 
+        z1[i] = flushDenormal(vn + out);
 
-    float getFeedbackOutput();
+        return out;
+    }
 };
 
 
-struct DiodeLadderFilter : DSPEffect {
+/**
+ * @brief Diode ladder filter over the sample type T
+ *
+ * T is float for a single voice or FloatLanes<N> for N independent voices, which run in the same
+ * instructions. Cutoff, resonance and saturation are set per voice. Blocks are passed as
+ * interleaved frames of N voices, one Resampler<N> filters all of them.
+ *
+ * @tparam T float or FloatLanes<N>
+ */
+template<typename T>
+struct BasicDiodeLadderFilter : DSPEffect {
+    static const int LANES = LaneCount<T>::value;
     static constexpr float NOISE_GAIN = 10e-9f;     // internal noise gain used for self-oscillation
     static constexpr float MAX_RESONANCE = 17.28f;  // max resonance value
     static constexpr float MAX_FREQUENCY = 20000.f; //
-    static const int IN = 0;
+    static const int OVERSAMPLE = 2;                // default factor of internal oversampling
+    static constexpr float TARGET_RATE = OVERSAMPLE * RS_REFERENCE_RATE;    // internal rate for automatic oversampling
+    static const int STAGES = DiodeLadderStages<T>::STAGES;
 
-    float fc, k, saturation, freqHz;
+    T fc, k, saturation, freqHz;
 
-    DiodeLadderStage *lpf1, *lpf2, *lpf3, *lpf4;
+    DiodeLadderStages<T> stages;
+    DiodeLadderStages<T> target;    // coefficients the stages glide to, its state is unused
+    int glide;
     Noise noise;
-    Resampler<1> *rs;
+    Resampler<LANES> rs;
+    bool autoOversampling = false;
 
-    bool low = false;
+    T gamma, gammaTarget;
+    T sg[STAGES], sgTarget[STAGES];
+    T in, out, out2;
 
-    float gamma;
-    float sg1, sg2, sg3, sg4;
-    float in, out, out2;
+    /* interleaved frames at host and internal rate */
+    double frames[RS_BUFFER_SIZE * LANES];
+    double up[RS_BUFFER_SIZE * LANES];
+    double data[RS_BUFFER_SIZE * LANES];
+    float rnd[RS_BUFFER_SIZE * LANES];
 
-    explicit DiodeLadderFilter(float sr);
+    explicit BasicDiodeLadderFilter(float sr);
     void init() override;
     void invalidate() override;
+    void settle();
     void process() override;
 
-    void process1();
-    void process2();
+    T process1(const T &x, const T &r, T &hp);
+    void processBlock(const float *in, float *out, int n) override;
 
 
     void setSamplerate(float sr) override;
 
 
-    void setFrequency(float fc);
-    void setResonance(float k);
-    void setIn(float in);
-    float getOut() const;
-    float getOut2() const;
-    void setSaturation(float saturation);
+    void setFrequency(const T &fc);
+    void setResonance(const T &k);
+    void setIn(const T &in);
+    const T &getOut() const;
+    const T &getOut2() const;
+    void setSaturation(const T &saturation);
 
 
-    float getFreqHz() {
+    const T &getFreqHz() const {
         return freqHz;
     }
 
 
+    /**
+     * @brief Switch the oversampling filters to the low latency IIR cascade
+     * @param lowLatency
+     */
+    void setLowLatency(bool lowLatency) {
+        rs.setLowLatency(lowLatency);
+    }
+
+
+    /**
+     * @brief Change the factor of internal oversampling, 1 runs the ladder at host rate
+     * @param factor Factor or RS_AUTO_FACTOR to derive it from the sample rate
+     */
+    void setOversampling(int factor) {
+        autoOversampling = factor == RS_AUTO_FACTOR;
+        factor = resolveOversampling(factor, sr, TARGET_RATE);
+
+        if (factor == rs.getFactor()) return;
+
+        rs.setFactor(factor);
+        invalidate();
+        settle();
+    }
+
+
+    int getOversampling() {
+        return rs.getFactor();
+    }
+
+
     void reset() {
-        lpf1->resetZ1();
-        lpf2->resetZ1();
-        lpf3->resetZ1();
-        lpf4->resetZ1();
-
-        lpf1->setFeedback(0.f);
-        lpf2->setFeedback(0.f);
-        lpf3->setFeedback(0.f);
-        lpf4->setFeedback(0.f);
+        stages.reset();
     }
 };
 
+
+typedef BasicDiodeLadderFilter<float> DiodeLadderFilter;
+typedef BasicDiodeLadderFilter<Float4> DiodeLadderFilter4;
+typedef BasicDiodeLadderFilter<Float8> DiodeLadderFilter8;
+
+
 }
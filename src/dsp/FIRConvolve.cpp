@@ -0,0 +1,354 @@
+#include "FIRConvolve.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FIR_X86
+#include <immintrin.h>
+#endif
+
+using namespace dsp;
+
+
+typedef double (*ConvolveDouble)(const double *h, const double *x, int n);
+typedef float (*ConvolveFloat)(const float *h, const float *x, int n);
+typedef void (*ConvolveFramesDouble)(const double *h, const double *x, int n, int channels, double *y);
+typedef void (*ConvolveFramesFloat)(const float *h, const float *x, int n, int channels, float *y);
+
+
+/**
+ * @brief Plain C versions, used as fallback and for the remaining taps
+ */
+template<typename T>
+static T convolveScalar(const T *h, const T *x, int n) {
+    T y = 0;
+
+    for (int i = 0; i < n; i++) {
+        y += h[i] * x[i];
+    }
+
+    return y;
+}
+
+
+template<typename T>
+static void convolveFramesScalar(const T *h, const T *x, int n, int channels, T *y) {
+    for (int c = 0; c < channels; c++) {
+        y[c] = 0;
+    }
+
+    for (int i = 0; i < n; i++) {
+        const T *frame = &x[i * channels];
+
+        for (int c = 0; c < channels; c++) {
+            y[c] += h[i] * frame[c];
+        }
+    }
+}
+
+
+#ifdef FIR_X86
+
+__attribute__((target("sse2")))
+static double convolveSSE2(const double *h, const double *x, int n) {
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    int i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(&h[i]), _mm_loadu_pd(&x[i])));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(&h[i + 2]), _mm_loadu_pd(&x[i + 2])));
+    }
+
+    acc0 = _mm_add_pd(acc0, acc1);
+    acc0 = _mm_add_sd(acc0, _mm_unpackhi_pd(acc0, acc0));
+
+    return _mm_cvtsd_f64(acc0) + convolveScalar(&h[i], &x[i], n - i);
+}
+
+
+__attribute__((target("sse2")))
+static float convolveSSE2(const float *h, const float *x, int n) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(&h[i]), _mm_loadu_ps(&x[i])));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(&h[i + 4]), _mm_loadu_ps(&x[i + 4])));
+    }
+
+    acc0 = _mm_add_ps(acc0, acc1);
+    acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+    acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 1));
+
+    return _mm_cvtss_f32(acc0) + convolveScalar(&h[i], &x[i], n - i);
+}
+
+
+__attribute__((target("avx2,fma")))
+static double convolveAVX2(const double *h, const double *x, int n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(&h[i]), _mm256_loadu_pd(&x[i]), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(&h[i + 4]), _mm256_loadu_pd(&x[i + 4]), acc1);
+    }
+
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(&h[i]), _mm256_loadu_pd(&x[i]), acc0);
+    }
+
+    acc0 = _mm256_add_pd(acc0, acc1);
+
+    __m128d y = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+    y = _mm_add_sd(y, _mm_unpackhi_pd(y, y));
+
+    return _mm_cvtsd_f64(y) + convolveScalar(&h[i], &x[i], n - i);
+}
+
+
+__attribute__((target("avx2,fma")))
+static float convolveAVX2(const float *h, const float *x, int n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    int i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(&h[i]), _mm256_loadu_ps(&x[i]), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(&h[i + 8]), _mm256_loadu_ps(&x[i + 8]), acc1);
+    }
+
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(&h[i]), _mm256_loadu_ps(&x[i]), acc0);
+    }
+
+    acc0 = _mm256_add_ps(acc0, acc1);
+
+    __m128 y = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+    y = _mm_add_ps(y, _mm_movehl_ps(y, y));
+    y = _mm_add_ss(y, _mm_shuffle_ps(y, y, 1));
+
+    return _mm_cvtss_f32(y) + convolveScalar(&h[i], &x[i], n - i);
+}
+
+/**
+ * @brief Frame versions, one register holds the same tap position of several channels
+ */
+__attribute__((target("sse2")))
+static void convolveFramesSSE2(const double *h, const double *x, int n, int channels, double *y) {
+    if (channels & 1) {
+        convolveFramesScalar(h, x, n, channels, y);
+        return;
+    }
+
+    for (int c = 0; c < channels; c += 2) {
+        __m128d acc = _mm_setzero_pd();
+
+        for (int i = 0; i < n; i++) {
+            acc = _mm_add_pd(acc, _mm_mul_pd(_mm_set1_pd(h[i]), _mm_loadu_pd(&x[i * channels + c])));
+        }
+
+        _mm_storeu_pd(&y[c], acc);
+    }
+}
+
+
+__attribute__((target("sse2")))
+static void convolveFramesSSE2(const float *h, const float *x, int n, int channels, float *y) {
+    if (channels & 3) {
+        convolveFramesScalar(h, x, n, channels, y);
+        return;
+    }
+
+    for (int c = 0; c < channels; c += 4) {
+        __m128 acc = _mm_setzero_ps();
+
+        for (int i = 0; i < n; i++) {
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(h[i]), _mm_loadu_ps(&x[i * channels + c])));
+        }
+
+        _mm_storeu_ps(&y[c], acc);
+    }
+}
+
+
+__attribute__((target("avx2,fma")))
+static void convolveFramesAVX2(const double *h, const double *x, int n, int channels, double *y) {
+    if (channels & 3) {
+        convolveFramesSSE2(h, x, n, channels, y);
+        return;
+    }
+
+    for (int c = 0; c < channels; c += 4) {
+        __m256d acc = _mm256_setzero_pd();
+
+        for (int i = 0; i < n; i++) {
+            acc = _mm256_fmadd_pd(_mm256_set1_pd(h[i]), _mm256_loadu_pd(&x[i * channels + c]), acc);
+        }
+
+        _mm256_storeu_pd(&y[c], acc);
+    }
+}
+
+
+__attribute__((target("avx2,fma")))
+static void convolveFramesAVX2(const float *h, const float *x, int n, int channels, float *y) {
+    if (channels & 7) {
+        convolveFramesSSE2(h, x, n, channels, y);
+        return;
+    }
+
+    for (int c = 0; c < channels; c += 8) {
+        __m256 acc = _mm256_setzero_ps();
+
+        for (int i = 0; i < n; i++) {
+            acc = _mm256_fmadd_ps(_mm256_set1_ps(h[i]), _mm256_loadu_ps(&x[i * channels + c]), acc);
+        }
+
+        _mm256_storeu_ps(&y[c], acc);
+    }
+}
+
+#endif
+
+
+/**
+ * @brief Instruction sets known to the dispatcher
+ */
+enum ConvolutionISA {
+    ISA_SCALAR,
+    ISA_SSE2,
+    ISA_AVX2
+};
+
+
+/**
+ * @brief Query the CPU once
+ * @return
+ */
+static ConvolutionISA detectISA() {
+#ifdef FIR_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return ISA_AVX2;
+    if (__builtin_cpu_supports("sse2")) return ISA_SSE2;
+#endif
+
+    return ISA_SCALAR;
+}
+
+
+static const ConvolutionISA isa = detectISA();
+
+
+static ConvolveDouble selectDouble() {
+#ifdef FIR_X86
+    switch (isa) {
+        case ISA_AVX2:
+            return convolveAVX2;
+        case ISA_SSE2:
+            return convolveSSE2;
+        default:
+            break;
+    }
+#endif
+
+    return convolveScalar<double>;
+}
+
+
+static ConvolveFloat selectFloat() {
+#ifdef FIR_X86
+    switch (isa) {
+        case ISA_AVX2:
+            return convolveAVX2;
+        case ISA_SSE2:
+            return convolveSSE2;
+        default:
+            break;
+    }
+#endif
+
+    return convolveScalar<float>;
+}
+
+
+static ConvolveFramesDouble selectFramesDouble() {
+#ifdef FIR_X86
+    switch (isa) {
+        case ISA_AVX2:
+            return convolveFramesAVX2;
+        case ISA_SSE2:
+            return convolveFramesSSE2;
+        default:
+            break;
+    }
+#endif
+
+    return convolveFramesScalar<double>;
+}
+
+
+static ConvolveFramesFloat selectFramesFloat() {
+#ifdef FIR_X86
+    switch (isa) {
+        case ISA_AVX2:
+            return convolveFramesAVX2;
+        case ISA_SSE2:
+            return convolveFramesSSE2;
+        default:
+            break;
+    }
+#endif
+
+    return convolveFramesScalar<float>;
+}
+
+
+static const ConvolveDouble convolveDouble = selectDouble();
+static const ConvolveFloat convolveFloat = selectFloat();
+static const ConvolveFramesDouble convolveFramesDouble = selectFramesDouble();
+static const ConvolveFramesFloat convolveFramesFloat = selectFramesFloat();
+
+
+double dsp::convolve(const double *h, const double *x, int n) {
+    return convolveDouble(h, x, n);
+}
+
+
+float dsp::convolve(const float *h, const float *x, int n) {
+    return convolveFloat(h, x, n);
+}
+
+
+void dsp::convolveFrames(const double *h, const double *x, int n, int channels, double *y) {
+    if (channels == 1) {
+        y[0] = convolveDouble(h, x, n);
+        return;
+    }
+
+    convolveFramesDouble(h, x, n, channels, y);
+}
+
+
+void dsp::convolveFrames(const float *h, const float *x, int n, int channels, float *y) {
+    if (channels == 1) {
+        y[0] = convolveFloat(h, x, n);
+        return;
+    }
+
+    convolveFramesFloat(h, x, n, channels, y);
+}
+
+
+const char *dsp::getConvolutionISA() {
+    switch (isa) {
+        case ISA_AVX2:
+            return "AVX2";
+        case ISA_SSE2:
+            return "SSE2";
+        default:
+            return "scalar";
+    }
+}
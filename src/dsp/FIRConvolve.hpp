@@ -0,0 +1,169 @@
+#pragma once
+
+#include <string.h>
+#include "DSPArena.hpp"
+
+/* define to run all FIR resampling kernels in single precision */
+// #define RS_SINGLE_PRECISION
+
+
+namespace dsp {
+
+#ifdef RS_SINGLE_PRECISION
+typedef float FIRSample;
+#else
+typedef double FIRSample;
+#endif
+
+
+/**
+ * @brief Dot product of a kernel and a contiguous signal window
+ *
+ * Dispatched once at startup to the widest instruction set supported by the CPU
+ * (AVX2/FMA, SSE2 or plain scalar code).
+ *
+ * @param h Kernel taps
+ * @param x Signal window
+ * @param n Length
+ * @return
+ */
+double convolve(const double *h, const double *x, int n);
+
+float convolve(const float *h, const float *x, int n);
+
+
+/**
+ * @brief Convolve one kernel with a window of interleaved frames, all channels at once
+ *
+ * Computes y[c] = sum h[k] * x[k * channels + c], the channels are processed side by side in
+ * SIMD registers. Mono windows are passed to convolve().
+ *
+ * @param h Kernel taps
+ * @param x Signal window, newest frame first
+ * @param n Length in frames
+ * @param channels Number of interleaved channels
+ * @param y Destination for one sample per channel
+ */
+void convolveFrames(const double *h, const double *x, int n, int channels, double *y);
+
+void convolveFrames(const float *h, const float *x, int n, int channels, float *y);
+
+
+/**
+ * @brief Name of the instruction set selected for convolve()
+ * @return
+ */
+const char *getConvolutionISA();
+
+
+/**
+ * @brief History of the last LENGTH samples of a FIR filter
+ *
+ * Every sample is stored twice, LENGTH apart, so the latest LENGTH samples are always
+ * contiguous in memory (newest first) and can be fed into convolve() directly. With more
+ * than one channel the history holds interleaved frames for convolveFrames(). The buffer is
+ * taken from the arena of the owning filter and sized to the filter length.
+ *
+ * @tparam T Sample type
+ * @tparam CHANNELS Interleaved channels per frame
+ */
+template<typename T, int CHANNELS = 1>
+struct FIRHistory {
+    T *buffer = nullptr;
+    int length = 0;
+    int index = 0;
+
+
+    /**
+     * @brief Space of the buffer in the arena
+     * @param length Filter length
+     * @return
+     */
+    static size_t footprint(int length) {
+        return DSPArena::footprint(2 * length * CHANNELS * sizeof(T));
+    }
+
+
+    /**
+     * @brief Take the buffer from the arena, called once
+     * @param length Filter length
+     * @param arena Arena of the filter
+     */
+    void init(int length, DSPArena &arena) {
+        FIRHistory::length = length;
+        buffer = arena.allocate<T>(2 * length * CHANNELS);
+        reset();
+    }
+
+
+    void reset() {
+        index = 0;
+        memset(buffer, 0, 2 * length * CHANNELS * sizeof(T));
+    }
+
+
+    /**
+     * @brief Fill the whole history with a constant, as if the signal had been there forever
+     * @param x
+     */
+    void fill(T x) {
+        for (int i = 0; i < 2 * length * CHANNELS; i++) {
+            buffer[i] = x;
+        }
+    }
+
+
+    /**
+     * @brief Fill every channel of the history with its own constant
+     * @param x One value per channel
+     */
+    void fillFrame(const T *x) {
+        for (int i = 0; i < 2 * length; i++) {
+            for (int c = 0; c < CHANNELS; c++) {
+                buffer[i * CHANNELS + c] = x[c];
+            }
+        }
+    }
+
+
+    /**
+     * @brief Add the next sample
+     * @param x
+     */
+    inline void push(T x) {
+        index += (index == 0) * length;
+        index--;
+
+        buffer[index] = x;
+        buffer[index + length] = x;
+    }
+
+
+    /**
+     * @brief Add the next frame
+     * @param x One sample per channel
+     */
+    inline void pushFrame(const T *x) {
+        index += (index == 0) * length;
+        index--;
+
+        T *a = &buffer[index * CHANNELS];
+        T *b = &buffer[(index + length) * CHANNELS];
+
+        for (int c = 0; c < CHANNELS; c++) {
+            a[c] = x[c];
+            b[c] = x[c];
+        }
+    }
+
+
+    /**
+     * @brief Window over the latest LENGTH samples, newest first
+     * @return
+     */
+    inline const T *window() const {
+        return &buffer[index * CHANNELS];
+    }
+};
+
+}
@@ -0,0 +1,178 @@
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include <string.h>
+#include "FIRKernel.hpp"
+
+using namespace dsp;
+
+
+/**
+ * @brief Allocate aligned storage and compute the taps for the given layout
+ * @param type Tap layout
+ * @param factor Oversampling factor
+ * @param quality Taps per input sample (order for half-band kernels)
+ * @param cutoff Cutoff relative to the nyquist frequency of the target rate
+ */
+FIRKernel::FIRKernel(FIRKernelType type, int factor, int quality, double cutoff) :
+        type(type), factor(factor), quality(quality), cutoff(cutoff) {
+    length = type == KERNEL_HALFBAND ? 2 * quality : factor * quality;
+
+    /* double taps first, single precision copy starts on the next cache line */
+    size_t size = length * sizeof(double);
+    size_t sizef = length * sizeof(float);
+    size_t offset = (size + FIR_KERNEL_ALIGNMENT - 1) / FIR_KERNEL_ALIGNMENT * FIR_KERNEL_ALIGNMENT;
+    size_t space = offset + sizef + FIR_KERNEL_ALIGNMENT;
+
+    storage.reset(new char[space]);
+
+    void *ptr = storage.get();
+    taps = (double *) std::align(FIR_KERNEL_ALIGNMENT, offset + sizef, ptr, space);
+    tapsf = (float *) ((char *) taps + offset);
+    memset(taps, 0, size);
+
+    switch (type) {
+        case KERNEL_LOWPASS:
+            computeLowpass();
+            break;
+        case KERNEL_POLYPHASE:
+            computePolyphase();
+            break;
+        case KERNEL_HALFBAND:
+            computeHalfBand();
+            break;
+        case KERNEL_HERMITE:
+            computeHermite();
+            break;
+        case KERNEL_LAGRANGE:
+            computeLagrange();
+            break;
+    }
+
+    for (int i = 0; i < length; i++) {
+        tapsf[i] = (float) taps[i];
+    }
+}
+
+
+/**
+ * @brief Windowed-sinc prototype
+ */
+void FIRKernel::computeLowpass() {
+    boxcarLowpassIR(taps, length, cutoff * 0.5 / factor);
+    blackmanHarrisWindow(taps, length);
+}
+
+
+/**
+ * @brief Split the prototype into phases, every sub-kernel normalized to unity gain at DC
+ */
+void FIRKernel::computePolyphase() {
+    std::vector<double> prototype(length);
+
+    boxcarLowpassIR(prototype.data(), length, cutoff * 0.5 / factor);
+    blackmanHarrisWindow(prototype.data(), length);
+
+    for (int i = 0; i < factor; i++) {
+        double sum = 0.;
+
+        for (int j = 0; j < quality; j++) {
+            sum += prototype[factor * j + i];
+        }
+
+        for (int j = 0; j < quality; j++) {
+            taps[quality * i + j] = prototype[factor * j + i] / sum;
+        }
+    }
+}
+
+
+/**
+ * @brief Keep the non-zero taps beside the center, normalized to unity gain at DC.
+ *        taps[i] weights the i-th newest sample of the even input stream.
+ */
+void FIRKernel::computeHalfBand() {
+    int len = 4 * quality - 1;
+    std::vector<double> prototype(len);
+
+    boxcarLowpassIR(prototype.data(), len, 0.25);
+    blackmanHarrisWindow(prototype.data(), len);
+
+    double sum = 0.;
+
+    for (int i = 0; i < length; i++) {
+        taps[i] = prototype[2 * i];
+        sum += taps[i];
+    }
+
+    for (int i = 0; i < length; i++) {
+        taps[i] *= 0.5 / sum;
+    }
+}
+
+
+/**
+ * @brief Catmull-Rom weights, phase i interpolates at (i + 1) / factor between the second and
+ *        third newest sample, newest sample first
+ */
+void FIRKernel::computeHermite() {
+    for (int i = 0; i < factor; i++) {
+        double t = (i + 1.) / factor;
+        double t2 = t * t;
+        double t3 = t2 * t;
+        double *h = &taps[quality * i];
+
+        h[0] = 0.5 * t3 - 0.5 * t2;
+        h[1] = -1.5 * t3 + 2. * t2 + 0.5 * t;
+        h[2] = 1.5 * t3 - 2.5 * t2 + 1.;
+        h[3] = -0.5 * t3 + t2 - 0.5 * t;
+    }
+}
+
+
+/**
+ * @brief Lagrange weights over quality points, phase i interpolates at (i + 1) / factor between
+ *        the two center points, newest sample first. Two points give linear interpolation.
+ */
+void FIRKernel::computeLagrange() {
+    int newest = quality / 2;
+
+    for (int i = 0; i < factor; i++) {
+        double t = (i + 1.) / factor;
+        double *h = &taps[quality * i];
+
+        for (int j = 0; j < quality; j++) {
+            int node = newest - j;
+            double w = 1.;
+
+            for (int m = newest - quality + 1; m <= newest; m++) {
+                if (m != node) w *= (t - m) / (node - m);
+            }
+
+            h[j] = w;
+        }
+    }
+}
+
+
+FIRKernelRef FIRKernelCache::get(FIRKernelType type, int factor, int quality, double cutoff) {
+    typedef std::tuple<int, int, int, double> Key;
+
+    static std::mutex mutex;
+    static std::map<Key, FIRKernelRef> kernels;
+
+    Key key(type, factor, quality, cutoff);
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = kernels.find(key);
+
+    if (it != kernels.end()) {
+        return it->second;
+    }
+
+    FIRKernelRef kernel = std::make_shared<const FIRKernel>(type, factor, quality, cutoff);
+    kernels[key] = kernel;
+
+    return kernel;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cmath>
+#include <memory>
+
+#define FIR_KERNEL_ALIGNMENT 64
+
+
+namespace dsp {
+
+/** The normalized sinc function. https://en.wikipedia.org/wiki/Sinc_function */
+inline double sinc(double x) {
+    if (x == 0.)
+        return 1.;
+    x *= M_PI;
+    return sin(x) / x;
+}
+
+
+/** Computes the impulse response of a boxcar lowpass filter */
+inline void boxcarLowpassIR(double *out, int len, double cutoff = 0.5) {
+    for (int i = 0; i < len; i++) {
+        double t = i - (len - 1) / 2.;
+        out[i] = 2 * cutoff * sinc(2 * cutoff * t);
+    }
+}
+
+
+inline void blackmanHarrisWindow(double *x, int len) {
+    // Constants from https://en.wikipedia.org/wiki/Window_function#Blackman%E2%80%93Harris_window
+    const double a0 = 0.35875;
+    const double a1 = 0.48829;
+    const double a2 = 0.14128;
+    const double a3 = 0.01168;
+    double factor = 2 * M_PI / (len - 1);
+    for (int i = 0; i < len; i++) {
+        x[i] *= +a0
+                - a1 * cos(1 * factor * i)
+                + a2 * cos(2 * factor * i)
+                - a3 * cos(3 * factor * i);
+    }
+}
+
+
+/**
+ * @brief Tap layouts provided by the kernel cache
+ *
+ * Worst image relative to the tone, 4x from 44.1 kHz. Measured on a steady sine through
+ * Resampler::upsample() with a 16384 point Blackman-Harris windowed DFT at the image frequencies,
+ * so values below about -140 dB only show the window floor:
+ *
+ *                    1 kHz     5 kHz    10 kHz   loss at 10 kHz
+ *    linear          -64 dB    -34 dB   -20 dB   1.4 dB
+ *    hermite         -92 dB    -47 dB   -27 dB   0.4 dB
+ *    lagrange 6    < -140 dB   -75 dB   -39 dB   0.15 dB
+ *    polyphase q8   -121 dB    -74 dB   -41 dB   0.5 dB
+ */
+enum FIRKernelType {
+    KERNEL_LOWPASS,     // windowed-sinc lowpass of length factor * quality
+    KERNEL_POLYPHASE,   // same prototype split into factor sub-kernels of quality taps
+    KERNEL_HALFBAND,    // the 2 * quality odd taps of a 2x half-band, without center and zeros
+    KERNEL_HERMITE,     // 4-point cubic Hermite weights for each of the factor phases
+    KERNEL_LAGRANGE     // quality-point Lagrange weights for each of the factor phases
+};
+
+
+/**
+ * @brief Read-only block of filter taps in double and single precision, aligned to a cache line
+ */
+struct FIRKernel {
+    FIRKernelType type;
+    int factor, quality;
+    double cutoff;
+
+    int length;
+    double *taps;
+    float *tapsf;
+
+    FIRKernel(FIRKernelType type, int factor, int quality, double cutoff);
+
+    FIRKernel(const FIRKernel &) = delete;
+    FIRKernel &operator=(const FIRKernel &) = delete;
+
+
+    /**
+     * @brief Get the taps in the requested precision
+     * @tparam T float or double
+     * @return
+     */
+    template<typename T>
+    const T *get() const;
+
+private:
+    std::unique_ptr<char[]> storage;
+
+    void computeLowpass();
+    void computePolyphase();
+    void computeHalfBand();
+    void computeHermite();
+    void computeLagrange();
+};
+
+
+template<>
+inline const double *FIRKernel::get<double>() const {
+    return taps;
+}
+
+
+template<>
+inline const float *FIRKernel::get<float>() const {
+    return tapsf;
+}
+
+
+typedef std::shared_ptr<const FIRKernel> FIRKernelRef;
+
+
+/**
+ * @brief Process-wide registry of FIR kernels
+ *
+ * Kernels are computed on first request and shared by all resamplers with the same
+ * configuration, they stay alive as long as the plugin is loaded.
+ */
+struct FIRKernelCache {
+
+    /**
+     * @brief Get a shared kernel, computes it if not present yet
+     * @param type Tap layout
+     * @param factor Oversampling factor
+     * @param quality Taps per input sample (order for half-band kernels)
+     * @param cutoff Cutoff relative to the nyquist frequency of the target rate
+     * @return
+     */
+    static FIRKernelRef get(FIRKernelType type, int factor, int quality, double cutoff);
+};
+
+}
@@ -3,14 +3,13 @@
 using namespace dsp;
 
 
-FastTan::FastTan(float sr) : WaveShaper(sr) {
+FastTan::FastTan(float sr) : WaveShaper(sr, 8, 16, UPSAMPLE_LINEAR, DOWNSAMPLE_HALFBAND, RS_ANY_FACTOR) {
     init();
-    noise = new Noise;
 }
 
 
 void FastTan::init() {
-    WaveShaper::rs = new Resampler<1>(8, 16);
+    WaveShaper::init();
 }
 
 
@@ -34,9 +33,16 @@ double FastTan::compute(double x) {
     in = fastatan(in * 10) / 10;
 
     in *= 1 / FASTTAN_GAIN * (1 + gain / 15);
-    if (blockDC) in = dc->filter(in);
+    if (blockDC) in = dc.filter(in);
 
     out = in;
 
     return out;
 }
+
+
+void FastTan::computeBlock(double *x, int n) {
+    for (int i = 0; i < n; i++) {
+        x[i] = FastTan::compute(x[i]);
+    }
+}
@@ -8,8 +8,6 @@ namespace dsp {
 
 struct FastTan : WaveShaper {
 
-    Noise *noise;
-
 public:
 
     explicit FastTan(float sr);
@@ -18,6 +16,7 @@ public:
     void invalidate() override;
     void process() override;
     double compute(double x) override;
+    void computeBlock(double *x, int n) override;
 
 };
 
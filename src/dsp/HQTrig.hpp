@@ -14,13 +14,13 @@ struct HQTanh : DSPEffect {
 
     int factor;
     double in, out, xn1, fn1;
-    Resampler<1> *rs;
+    Resampler<1> rs;
 
 
-    HQTanh(float sr, int factor, int quality = 4) : DSPEffect(sr) {
+    HQTanh(float sr, int factor, int quality = 4) : DSPEffect(sr), rs(factor, factor * quality) {
         HQTanh::factor = factor;
 
-        rs = new Resampler<1>(factor, factor * quality);
+        init();
     }
 
 
@@ -29,12 +29,15 @@ struct HQTanh : DSPEffect {
      * @return
      */
     float getOversampledRate() {
-        return sr * rs->getFactor();
+        return sr * rs.getFactor();
     }
 
 
     void init() override {
-        DSPEffect::init();
+        in = 0;
+        out = 0;
+        xn1 = 0;
+        fn1 = 0;
     }
 
 
@@ -56,13 +59,18 @@ struct HQTanh : DSPEffect {
     }
 
 
+    float processSample(float x) override {
+        return (float) next(x);
+    }
+
+
     /**
      * @brief Generate an anti-aliased tanh
      * @param x
      * @return
      */
     inline double computeAA(double x) {
-        double fn = log(cosh(x));
+        double fn = logcosh(x);
         double xn, out;
 
         if (abs(x - xn1) < 10e-10) {
@@ -80,17 +88,38 @@ struct HQTanh : DSPEffect {
 
 
     /**
-     * @brief Compute tanh
+     * @brief Anti-aliased tanh of a block, the antiderivatives of the whole block are computed
+     *        in one vectorized pass before the differences
+     * @param x Input
+     * @param y Output, must not overlap x
+     * @param n Number of samples
      */
-    inline void process() override {
-        rs->doUpsample(STD_CHANNEL, in);
+    inline void computeBlockAA(const double *x, double *y, int n) {
+        logcoshBlock(x, y, n);
 
-        for (int i = 0; i < rs->getFactor(); i++) {
-            double x = rs->getUpsampled(STD_CHANNEL)[i];
-            rs->data[STD_CHANNEL][i] = computeAA(x);
+        for (int i = 0; i < n; i++) {
+            double fn = y[i];
+
+            if (abs(x[i] - xn1) < 10e-10) {
+                y[i] = tanh((x[i] + xn1) / 2.);
+            } else {
+                y[i] = (fn - fn1) / (x[i] - xn1);
+            }
+
+            fn1 = fn;
+            xn1 = x[i];
         }
+    }
+
 
-        out = rs->getDownsampled(STD_CHANNEL);
+    /**
+     * @brief Compute tanh
+     */
+    inline void process() override {
+        rs.doUpsample(STD_CHANNEL, in);
+        computeBlockAA(rs.getUpsampled(STD_CHANNEL), rs.data[STD_CHANNEL], rs.getFactor());
+
+        out = rs.getDownsampled(STD_CHANNEL);
     }
 
 };
@@ -103,13 +132,13 @@ struct HQClip : DSPEffect {
 
     int factor;
     double in, out, xn1, fn1;
-    Resampler<1> *rs;
+    Resampler<1> rs;
 
 
-    HQClip(float sr, int factor, int quality = 4) : DSPEffect(sr) {
+    HQClip(float sr, int factor, int quality = 4) : DSPEffect(sr), rs(factor, factor * quality) {
         HQClip::factor = factor;
 
-        rs = new Resampler<1>(factor, factor * quality);
+        init();
     }
 
 
@@ -118,12 +147,15 @@ struct HQClip : DSPEffect {
      * @return
      */
     float getOversampledRate() {
-        return sr * rs->getFactor();
+        return sr * rs.getFactor();
     }
 
 
     void init() override {
-        DSPEffect::init();
+        in = 0;
+        out = 0;
+        xn1 = 0;
+        fn1 = 0;
     }
 
 
@@ -145,6 +177,11 @@ struct HQClip : DSPEffect {
     }
 
 
+    float processSample(float x) override {
+        return (float) next(x);
+    }
+
+
     /**
      * @brief Generate an anti-aliased clipping
      * @param x
@@ -174,14 +211,14 @@ struct HQClip : DSPEffect {
      * @brief Compute tanh
      */
     inline void process() override {
-        rs->doUpsample(STD_CHANNEL, in);
+        rs.doUpsample(STD_CHANNEL, in);
 
-        for (int i = 0; i < rs->getFactor(); i++) {
-            double x = rs->getUpsampled(STD_CHANNEL)[i];
-            rs->data[STD_CHANNEL][i] = computeAA(x);
+        for (int i = 0; i < rs.getFactor(); i++) {
+            double x = rs.getUpsampled(STD_CHANNEL)[i];
+            rs.data[STD_CHANNEL][i] = computeAA(x);
         }
 
-        out = rs->getDownsampled(STD_CHANNEL);
+        out = rs.getDownsampled(STD_CHANNEL);
     }
 
 };
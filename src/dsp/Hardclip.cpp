@@ -3,15 +3,14 @@
 using namespace dsp;
 
 
-Hardclip::Hardclip(float sr) : WaveShaper(sr) {
+Hardclip::Hardclip(float sr) : WaveShaper(sr), hqclip(sr, 4) {
     init();
-    noise = new Noise;
-    hqclip = new HQClip(sr, 4);
 }
 
 
 void Hardclip::init() {
-    WaveShaper::rs = new Resampler<1>(1);
+    WaveShaper::init();
+    hqclip.init();
 }
 
 
@@ -32,10 +31,10 @@ double Hardclip::compute(double x) {
 
     in *= HARDCLIP_GAIN;
 
-    in = hqclip->next(in);
+    in = hqclip.next(in);
 
     in *= 1 / HARDCLIP_GAIN * 0.3;
-    if (blockDC) in = dc->filter(in);
+    if (blockDC) in = dc.filter(in);
 
     out = in;
 
@@ -8,8 +8,7 @@ namespace dsp {
 
 struct Hardclip : WaveShaper {
 
-    Noise *noise;
-    HQClip *hqclip;
+    HQClip hqclip;
 
 
 public:
@@ -0,0 +1,92 @@
+#include <cmath>
+#include "IIRHalfBand.hpp"
+
+using namespace dsp;
+
+
+/**
+ * @brief Integer power by squaring
+ */
+static double ipow(double x, long n) {
+    double z = 1.;
+
+    while (n != 0) {
+        if (n & 1) z *= x;
+
+        n >>= 1;
+        x *= x;
+    }
+
+    return z;
+}
+
+
+/**
+ * @brief Selectivity factor k and nome q of the elliptic design for a given transition
+ */
+static void computeTransitionParams(double transition, double &k, double &q) {
+    k = tan((1. - 2. * transition) * M_PI / 4.);
+    k *= k;
+
+    double kksqrt = pow(1. - k * k, 0.25);
+    double e = 0.5 * (1. - kksqrt) / (1. + kksqrt);
+    double e4 = e * e * e * e;
+
+    q = e * (1. + e4 * (2. + e4 * (15. + 150. * e4)));
+}
+
+
+/**
+ * @brief Theta function series of the numerator
+ */
+static double computeAccNum(double q, int order, int c) {
+    double acc = 0., term;
+    int sign = 1;
+    int i = 0;
+
+    do {
+        term = ipow(q, (long) i * (i + 1)) * sin((2 * i + 1) * c * M_PI / order) * sign;
+        acc += term;
+        sign = -sign;
+        i++;
+    } while (fabs(term) > 1e-100);
+
+    return acc;
+}
+
+
+/**
+ * @brief Theta function series of the denominator
+ */
+static double computeAccDen(double q, int order, int c) {
+    double acc = 0., term;
+    int sign = -1;
+    int i = 1;
+
+    do {
+        term = ipow(q, (long) i * i) * cos(2 * i * c * M_PI / order) * sign;
+        acc += term;
+        sign = -sign;
+        i++;
+    } while (fabs(term) > 1e-100);
+
+    return acc;
+}
+
+
+void dsp::computeHalfBandIIRCoefs(double *coefs, int numCoefs, double transition) {
+    double k, q;
+    computeTransitionParams(transition, k, q);
+
+    int order = 2 * numCoefs + 1;
+
+    for (int i = 0; i < numCoefs; i++) {
+        double num = computeAccNum(q, order, i + 1) * pow(q, 0.25);
+        double den = computeAccDen(q, order, i + 1) + 0.5;
+        double ww = num / den;
+        double wwsq = ww * ww;
+
+        double x = sqrt((1. - wwsq * k) * (1. - wwsq / k)) / (1. + wwsq);
+        coefs[i] = (1. - x) / (1. + x);
+    }
+}
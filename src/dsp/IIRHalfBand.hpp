@@ -0,0 +1,301 @@
+#pragma once
+
+#include <string.h>
+#include "DSPArena.hpp"
+
+#define IIR_MAX_COEFS 12
+#define IIR_MAX_STAGES 5
+#define IIR_TRANSITION 0.05
+
+
+namespace dsp {
+
+/**
+ * @brief Design the allpass coefficients of a polyphase IIR half-band filter
+ *
+ * Elliptic half-band designed as two parallel chains of first order allpass sections in z^-2
+ * (see Valenzuela/Constantinides 1983). Coefficients with an even index belong to the first
+ * chain, odd ones to the second.
+ *
+ * @param coefs Destination for the coefficients
+ * @param numCoefs Number of coefficients, the filter order is 2 * numCoefs + 1
+ * @param transition Transition bandwidth relative to the input rate, the passband ends at 0.25 - transition / 2
+ */
+void computeHalfBandIIRCoefs(double *coefs, int numCoefs, double transition);
+
+
+/**
+ * @brief One 2x stage of a polyphase IIR half-band filter, used for up- and downsampling
+ *
+ * Each branch is a chain of first order allpass sections running at the lower rate, which
+ * gives a steep elliptic response with only a few multiplications and a group delay of a
+ * couple of samples. The phase response is not linear.
+ *
+ * Samples are handled as frames of CHANNELS interleaved values. The recursion only runs along
+ * the sections, so all channels of a frame are computed side by side. Coefficients and state
+ * are taken from the arena of the owning filter and sized to the number of sections.
+ *
+ * @tparam CHANNELS Interleaved channels per frame
+ */
+template<int CHANNELS = 1>
+struct IIRHalfBandStage {
+    double *coefs = nullptr;
+    double *x1 = nullptr, *y1 = nullptr;    // state of section i at [i * CHANNELS]
+    int numCoefs = 0;
+
+
+    /**
+     * @brief Space of coefficients and state in the arena
+     * @param numCoefs Number of allpass sections of both chains
+     * @return
+     */
+    static size_t footprint(int numCoefs) {
+        return DSPArena::footprint(numCoefs * sizeof(double)) +
+               2 * DSPArena::footprint(numCoefs * CHANNELS * sizeof(double));
+    }
+
+
+    /**
+     * @brief Design the stage, called once
+     * @param numCoefs Number of allpass sections of both chains
+     * @param transition Transition bandwidth relative to the higher rate
+     * @param arena Arena of the filter
+     */
+    void init(int numCoefs, double transition, DSPArena &arena) {
+        IIRHalfBandStage::numCoefs = numCoefs;
+
+        coefs = arena.allocate<double>(numCoefs);
+        x1 = arena.allocate<double>(numCoefs * CHANNELS);
+        y1 = arena.allocate<double>(numCoefs * CHANNELS);
+
+        computeHalfBandIIRCoefs(coefs, numCoefs, transition);
+        reset();
+    }
+
+
+    void reset() {
+        memset(x1, 0, numCoefs * CHANNELS * sizeof(double));
+        memset(y1, 0, numCoefs * CHANNELS * sizeof(double));
+    }
+
+
+    /**
+     * @brief Set the state to a settled constant signal, allpass sections pass DC unchanged
+     * @param x One value per channel
+     */
+    void prime(const double *x) {
+        for (int i = 0; i < numCoefs; i++) {
+            for (int c = 0; c < CHANNELS; c++) {
+                x1[i * CHANNELS + c] = x[c];
+                y1[i * CHANNELS + c] = x[c];
+            }
+        }
+    }
+
+
+    /**
+     * @brief Run both allpass chains
+     * @param a Input and output frame of the first chain
+     * @param b Input and output frame of the second chain
+     */
+    inline void run(double *a, double *b) {
+        for (int i = 0; i < numCoefs; i++) {
+            double *x = (i & 1) ? b : a;
+            double *xs = &x1[i * CHANNELS], *ys = &y1[i * CHANNELS];
+
+            for (int c = 0; c < CHANNELS; c++) {
+                double y = coefs[i] * (x[c] - ys[c]) + xs[c];
+
+                xs[c] = x[c];
+                ys[c] = y;
+                x[c] = y;
+            }
+        }
+    }
+
+
+    /**
+     * @brief Consume two frames and return one decimated frame
+     * @param x0 Older frame
+     * @param x1 Newer frame
+     * @param out Destination for one frame
+     */
+    void decimate(const double *x0, const double *x1, double *out) {
+        double a[CHANNELS], b[CHANNELS];
+
+        memcpy(a, x1, sizeof(a));
+        memcpy(b, x0, sizeof(b));
+        run(a, b);
+
+        for (int c = 0; c < CHANNELS; c++) {
+            out[c] = 0.5 * (a[c] + b[c]);
+        }
+    }
+
+
+    /**
+     * @brief Create two frames out of one
+     * @param in Input frame
+     * @param out Destination for the older and the newer frame
+     */
+    void interpolate(const double *in, double *out) {
+        double *a = out, *b = &out[CHANNELS];
+
+        memcpy(a, in, CHANNELS * sizeof(double));
+        memcpy(b, in, CHANNELS * sizeof(double));
+        run(a, b);
+    }
+};
+
+
+/**
+ * @brief Cascade of 2x IIR half-band stages, power of two factors only
+ *
+ * The stage next to the base rate gets the full number of coefficients, stages at higher
+ * rates only have to keep the base band free and get away with fewer and a wider transition.
+ *
+ * @tparam CHANNELS Interleaved channels per frame
+ */
+template<int CHANNELS = 1>
+struct IIRHalfBandCascade {
+    IIRHalfBandStage<CHANNELS> stages[IIR_MAX_STAGES];
+    int oversample, numStages;
+
+
+    /**
+     * @brief Constructor
+     * @param oversample Oversampling factor, must be a power of two
+     * @param numCoefs Coefficients of the stage next to the base rate
+     * @param arena Arena with room for footprint(oversample, numCoefs)
+     */
+    IIRHalfBandCascade(int oversample, int numCoefs, DSPArena &arena) {
+        init(oversample, numCoefs, arena);
+    }
+
+
+    /**
+     * @brief Space of the cascade and all its stages in the arena
+     * @param oversample Oversampling factor, must be a power of two
+     * @param numCoefs Coefficients of the stage next to the base rate
+     * @return
+     */
+    static size_t footprint(int oversample, int numCoefs) {
+        size_t bytes = DSPArena::footprint(sizeof(IIRHalfBandCascade));
+        int n = clampCoefs(numCoefs);
+
+        for (int i = 0; i < countStages(oversample); i++) {
+            bytes += IIRHalfBandStage<CHANNELS>::footprint(n);
+            n = clampCoefs(n / 2);
+        }
+
+        return bytes;
+    }
+
+
+    /**
+     * @brief Design all stages for a given factor, called once
+     * @param oversample Oversampling factor, must be a power of two
+     * @param numCoefs Coefficients of the stage next to the base rate
+     * @param arena Arena of the filter
+     */
+    void init(int oversample, int numCoefs, DSPArena &arena) {
+        IIRHalfBandCascade::oversample = oversample;
+        numStages = countStages(oversample);
+
+        /* stage 0 runs at the base rate, the passband shrinks relative to the rate above it */
+        double passband = 0.25 - IIR_TRANSITION / 2;
+        int n = clampCoefs(numCoefs);
+
+        for (int i = 0; i < numStages; i++) {
+            stages[i].init(n, 2 * (0.25 - passband), arena);
+
+            passband /= 2;
+            n = clampCoefs(n / 2);
+        }
+    }
+
+
+    static int countStages(int oversample) {
+        int n = 0;
+
+        while ((1 << n) < oversample && n < IIR_MAX_STAGES) {
+            n++;
+        }
+
+        return n;
+    }
+
+
+    static int clampCoefs(int numCoefs) {
+        if (numCoefs < 2) return 2;
+        if (numCoefs > IIR_MAX_COEFS) return IIR_MAX_COEFS;
+        return numCoefs;
+    }
+
+
+    /**
+     * @brief Check if a factor can be handled by the cascade
+     * @param oversample
+     * @return
+     */
+    static bool supports(int oversample) {
+        return oversample > 1 && (oversample & (oversample - 1)) == 0 &&
+               oversample <= (1 << IIR_MAX_STAGES);
+    }
+
+
+    void reset() {
+        for (int i = 0; i < numStages; i++) {
+            stages[i].reset();
+        }
+    }
+
+
+    void prime(const double *x) {
+        for (int i = 0; i < numStages; i++) {
+            stages[i].prime(x);
+        }
+    }
+
+
+    /** `in` is one frame, `out` must be OVERSAMPLE frames */
+    void upsample(const double *in, double *out) {
+        double buffer[(1 << IIR_MAX_STAGES) * CHANNELS];
+        memcpy(out, in, CHANNELS * sizeof(double));
+
+        // Double the data stage by stage, from the base rate up to the highest rate
+        int n = 1;
+
+        for (int i = 0; i < numStages; i++) {
+            memcpy(buffer, out, n * CHANNELS * sizeof(double));
+
+            for (int j = 0; j < n; j++) {
+                stages[i].interpolate(&buffer[j * CHANNELS], &out[2 * j * CHANNELS]);
+            }
+
+            n *= 2;
+        }
+    }
+
+
+    /** `in` must be OVERSAMPLE frames, `out` is one frame */
+    void downsample(const double *in, double *out) {
+        double buffer[(1 << IIR_MAX_STAGES) * CHANNELS];
+        memcpy(buffer, in, oversample * CHANNELS * sizeof(double));
+
+        // Halve the data in place stage by stage, from the highest rate down to the base rate
+        int n = oversample;
+
+        for (int i = numStages - 1; i >= 0; i--) {
+            n /= 2;
+
+            for (int j = 0; j < n; j++) {
+                stages[i].decimate(&buffer[2 * j * CHANNELS], &buffer[(2 * j + 1) * CHANNELS], &buffer[j * CHANNELS]);
+            }
+        }
+
+        memcpy(out, buffer, CHANNELS * sizeof(double));
+    }
+};
+
+}
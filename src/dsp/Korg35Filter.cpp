@@ -18,119 +18,106 @@
 
 #include "Korg35Filter.hpp"
 #include "DSPEffect.hpp"
+#include "DSPVecMath.hpp"
 
 
-dsp::Korg35FilterStage::Korg35FilterStage(float sr, FilterType type) : DSPEffect(sr) {
-    this->type = type;
-}
+void dsp::Korg35Filter::init() {
+    fc = 1.f;
+    peak = 0.f;
+    sat = 1.f;
+    in = 0.f;
+    out = 0.f;
 
+    stages.reset();
 
-void dsp::Korg35FilterStage::init() {
-    type = LPF1;
-    alpha = 1.f;
-    beta = 1.f;
-    zn1 = 0;
-    fc = 0;
+    invalidate();
+    settle();
 }
 
 
-void dsp::Korg35FilterStage::invalidate() {
-    // only process in dedicated mode
-    if (!dedicated) return;
+/**
+ * @brief Calculate the coefficients for frequency & peak, the filter glides to them over the next
+ *        control block
+ */
+void dsp::Korg35Filter::invalidate() {
+    float frqHz = MAX_FREQUENCY / 1000.f * vpow(1000.f, fc);
 
-    float wd = 2 * PI * fc;
+    float wd = 2 * PI * frqHz;
     float T = 1 / sr;
-    float wa = (2 / T) * tan(wd * T / 2);
+    float wa = (2 / T) * vtan(wd * T / 2);
     float g = wa * T / 2;
 
-    alpha = g / (1.f + g);
-}
-
-
-void dsp::Korg35FilterStage::process() {
-    // v(n)
-    float vn = (in - zn1) * alpha;
-
-    float lpf = vn + zn1;
-
-    zn1 = vn + lpf;
-
-    // switch filter type
-    if (type == LPF1) {
-        out = lpf;
-    } else {
-        float hpf = in - lpf;
-        out = hpf;
-    }
+    GTarget = g / (1.f + g);
+    GaTarget = 1.f / (1.f - peak * GTarget + peak * GTarget * GTarget);
+    kTarget = peak;
 
+    glide = DSP_CONTROL_BLOCK;
 }
 
 
-void dsp::Korg35Filter::init() {
-    fc = sr / 2;
-    peak = 0.f;
+/**
+ * @brief Jump to the current coefficients without gliding
+ */
+void dsp::Korg35Filter::settle() {
+    G = GTarget;
+    Ga = GaTarget;
+    k = kTarget;
+    glide = 0;
 
-    lpf->init();
-    hpf1->init();
-    hpf2->init();
+    stages.setGain(G);
 }
 
 
-void dsp::Korg35Filter::invalidate() {
-    float frqHz = MAX_FREQUENCY / 1000.f * powf(1000.f, fc);
-
-    float wd = 2 * PI * frqHz;
-    float T = 1 / sr;
-    float wa = (2 / T) * tan(wd * T / 2);
-    float g = wa * T / 2;
+void dsp::Korg35Filter::process() {
+    processBlock(&in, &out, 1);
+}
 
-    float G = g / (1.f + g);
 
-    // set alphas
-    lpf->alpha = G;
-    hpf1->alpha = G;
-    hpf2->alpha = G;
+/**
+ * @brief Filter a block of samples, the stages are copied to a local block for the whole loop
+ * @param in Input samples
+ * @param out Lowpass output
+ * @param n Number of samples
+ */
+void dsp::Korg35Filter::processBlock(const float *in, float *out, int n) {
+    Korg35Stages s = stages;
 
-    hpf2->beta = -1.f * G / (1.f + g);
-    lpf->beta = 1.f / (1.f + g);
+    for (int i = 0; i < n; i++) {
+        /* the coefficients glide between the control blocks */
+        if (glide > 0) {
+            float w = 1.f / glide;
 
-    Ga = 1.f / (1.f - peak * G + peak * G * G);
-}
+            G += (GTarget - G) * w;
+            Ga += (GaTarget - Ga) * w;
+            k += (kTarget - k) * w;
+            glide--;
 
+            s.setGain(G);
+        }
 
-void dsp::Korg35Filter::process() {
-    hpf1->in = in;
-    hpf1->process();
-    float y1 = hpf1->out;
+        float y1 = in[i] - s.lowpass(Korg35Stages::HPF1, in[i]);
 
-    float s35h = hpf2->getFeedback() + lpf->getFeedback();
+        float s35h = s.getFeedback(Korg35Stages::HPF2) + s.getFeedback(Korg35Stages::LPF);
 
-    float u = Ga * (y1 + s35h);
-    float y = peak * u;
+        float u = Ga * (y1 + s35h);
+        float y = k * u;
 
-    y = tanh(sat * y);
+        y = vtanh(sat * y);
 
-    hpf2->in = y;
-    hpf2->process();
+        float y2 = y - s.lowpass(Korg35Stages::HPF2, y);
+        s.lowpass(Korg35Stages::LPF, y2);
 
-    lpf->in = hpf2->out;
-    lpf->process();
+        if (k > 0) {
+            y *= 1 / k; // normalize
+        }
 
-    if (peak > 0) {
-        y *= 1 / peak; // normalize
+        out[i] = y;
     }
 
-    out = y;
+    stages = s;
 }
 
 
 void dsp::Korg35Filter::setSamplerate(float sr) {
     DSPEffect::setSamplerate(sr);
-
-    // derive samplerate change
-    lpf->setSamplerate(sr);
-    hpf1->setSamplerate(sr);
-    hpf2->setSamplerate(sr);
-
-    invalidate();
 }
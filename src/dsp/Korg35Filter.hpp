@@ -20,6 +20,7 @@
 
 
 #include "DSPEffect.hpp"
+#include "DSPSystem.hpp"
 #include "engine.hpp"
 #include "DSPMath.hpp"
 
@@ -27,40 +28,77 @@
 
 namespace dsp {
 
-struct Korg35FilterStage : DSPEffect {
-    enum FilterType {
-        LPF1,   // lowpass stage
-        HPF1    // highpass stage
+/**
+ * @brief Coefficients and state of the three one-pole stages of the Korg35, stored as one array
+ *        per field in a single cache line
+ */
+struct alignas(64) Korg35Stages {
+    enum Stage {
+        LPF,    // lowpass stage in the feedback path
+        HPF1,   // input highpass
+        HPF2,   // highpass in the feedback path
+        STAGES
     };
 
-    bool dedicated = false;
+    float zn1[STAGES];
+    float alpha[STAGES];
+    float beta[STAGES];
 
-    float fc;
-    FilterType type;
-    float alpha, beta;
-    float zn1;
 
-    float in, out;
+    void reset() {
+        for (int i = 0; i < STAGES; i++) {
+            zn1[i] = 0.f;
+            alpha[i] = 1.f;
+            beta[i] = 1.f;
+        }
+    }
 
-    Korg35FilterStage(float sr, FilterType type);
 
+    /**
+     * @brief Set the coefficients of all stages from the shared gain G = g / (1 + g)
+     * @param G
+     */
+    inline void setGain(float G) {
+        alpha[LPF] = G;
+        alpha[HPF1] = G;
+        alpha[HPF2] = G;
 
-    inline float getFeedback() {
-        return zn1 * beta;
+        beta[HPF2] = -G * (1.f - G);
+        beta[LPF] = 1.f - G;
     }
 
 
-    void init() override;
-    void invalidate() override;
-    void process() override;
+    inline float getFeedback(int i) const {
+        return zn1[i] * beta[i];
+    }
+
+
+    /**
+     * @brief Run one stage as lowpass, the highpass output is the input minus the result
+     * @param i Stage index
+     * @param x Input sample
+     * @return Lowpass output
+     */
+    inline float lowpass(int i, float x) {
+        float vn = (x - zn1[i]) * alpha[i];
+        float lpf = vn + zn1[i];
+
+        zn1[i] = flushDenormal(vn + lpf);
+
+        return lpf;
+    }
 };
 
 
 struct Korg35Filter : DSPEffect {
     static constexpr float MAX_FREQUENCY = 20000.f;
 
-    Korg35FilterStage *lpf, *hpf1, *hpf2;
-    float Ga;
+    Korg35Stages stages;
+
+    /* stage gain, loop gain and peak in use, they glide to the targets over one control block */
+    float G, Ga, k;
+    float GTarget, GaTarget, kTarget;
+    int glide;
 
     float in, out;
 
@@ -69,15 +107,15 @@ struct Korg35Filter : DSPEffect {
 
 
     Korg35Filter(float sr) : DSPEffect(sr) {
-        lpf = new Korg35FilterStage(sr, Korg35FilterStage::LPF1);
-        hpf1 = new Korg35FilterStage(sr, Korg35FilterStage::HPF1);
-        hpf2 = new Korg35FilterStage(sr, Korg35FilterStage::HPF1);
+        init();
     }
 
 
     void init() override;
     void invalidate() override;
+    void settle();
     void process() override;
+    void processBlock(const float *in, float *out, int n) override;
     void setSamplerate(float sr) override;
 };
 
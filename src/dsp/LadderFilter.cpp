@@ -1,17 +1,34 @@
+#include <algorithm>
 #include "LadderFilter.hpp"
 
-using namespace dsp;
+namespace dsp {
 
 
 /**
- * @brief Check parameter
+ * @brief Calculate the coefficients for frequency & resonance, the filter glides to them over the
+ *        next control block
  */
-void LadderFilter::invalidate() {
-    // Set coefficients given frequency & resonance [0.0...1.0]
-    q = 1.0f - freqExp;
-    p = freqExp + 0.8f * freqExp * q;
-    f = p + p - 1.0f;
-    q = resExp * (1.0f + 0.5f * q * (1.0f - q + 5.6f * q * q));
+template<typename T>
+void BasicLadderFilter<T>::invalidate() {
+    T t = 1.0f - freqExp;
+
+    pTarget = freqExp + 0.8f * freqExp * t;
+    fTarget = pTarget + pTarget - 1.0f;
+    qTarget = resExp * (1.0f + 0.5f * t * (1.0f - t + 5.6f * t * t));
+
+    glide = DSP_CONTROL_BLOCK;
+}
+
+
+/**
+ * @brief Jump to the current coefficients without gliding
+ */
+template<typename T>
+void BasicLadderFilter<T>::settle() {
+    f = fTarget;
+    p = pTarget;
+    q = qTarget;
+    glide = 0;
 }
 
 
@@ -19,49 +36,114 @@ void LadderFilter::invalidate() {
  * @brief Calculate new sample
  * @return
  */
-void LadderFilter::process() {
-    rs->doUpsample(LOWPASS, in);
+template<typename T>
+void BasicLadderFilter<T>::process() {
+    processBlock(&lane(in, 0), &lane(lpOut, 0), 1);
+}
+
+
+/**
+ * @brief Filter a block of frames, the ladder state is kept in locals for the whole block
+ * @param in N interleaved input frames of LANES voices
+ * @param out N interleaved lowpass frames
+ * @param n Number of frames
+ */
+template<typename T>
+void BasicLadderFilter<T>::processBlock(const float *in, float *out, int n) {
+    int factor = rs.getFactor();
+    int blockSize = rs.getBlockSize();
+
+    T s0 = b0, s1 = b1, s2 = b2, s3 = b3, s4 = b4, s5 = b5, sx = bx;
+    T light = lightValue;
+    T t1, t2, u, r, v;
+
+    T overdrive = 1.f + drive * 40.f;
+    T gain;
 
-    for (int i = 0; i < rs->getFactor(); i++) {
-        float x = rs->getUpsampled(LOWPASS)[i];
+    for (int c = 0; c < LANES; c++) {
+        lane(gain, c) = INPUT_GAIN / (lane(drive, c) * 20 + 1) * (quadraticBipolar(lane(drive, c) * 3) + 1);
+    }
+
+    /* split into chunks which fit into the resampler buffer */
+    for (int i = 0; i < n; i += blockSize) {
+        int len = std::min(blockSize, n - i);
+
+        for (int j = 0; j < len * LANES; j++) {
+            frames[j] = clamp(in[i * LANES + j] / INPUT_GAIN, -0.8f, 0.8f);
+        }
+
+        rs.upsampleFrames(frames, up, len);
+        noise.fill(rnd, len * factor * LANES, NOISE_GAIN);
+
+        for (int j = 0, m = 0; j < len; j++) {
+            /* the coefficients glide between the control blocks */
+            if (glide > 0) {
+                float w = 1.f / glide;
+
+                f += (fTarget - f) * w;
+                p += (pTarget - p) * w;
+                q += (qTarget - q) * w;
+                glide--;
+            }
 
-        // non linear feedback with nice saturation
-        x -= fastatan(bx * q);
+            for (int l = 0; l < factor; l++, m++) {
+                for (int c = 0; c < LANES; c++) {
+                    lane(u, c) = (float) up[m * LANES + c];
+                    lane(r, c) = rnd[m * LANES + c];
+                }
 
-        t1 = b1;
-        b1 = ((x + b0) * p - b1 * f);
+                // non linear feedback with nice saturation
+                u -= fastatan(sx * q);
 
-        t2 = b2;
-        b2 = ((b1 + t1) * p - b2 * f);
+                t1 = s1;
+                s1 = ((u + s0) * p - s1 * f);
 
-        t1 = b3;
-        b3 = ((b2 + t2) * p - b3 * f);
+                t2 = s2;
+                s2 = ((s1 + t1) * p - s2 * f);
 
-        t2 = b4;
-        b4 = ((b3 + t1) * p - b4 * f);
+                t1 = s3;
+                s3 = ((s2 + t2) * p - s3 * f);
 
-        b5 = ((b4 + t2) * p - b5 * f);
+                t2 = s4;
+                s4 = ((s3 + t1) * p - s4 * f);
 
-        // fade over filter poles from 3dB/oct (1P) => 48dB/oct (5P)
-        bx = fade5(b1, b2, b3, b4, b5, slope);
+                s5 = ((s4 + t2) * p - s5 * f);
 
-        // saturate and add very low noise to have self oscillation with no input and high res
-        b0 = fastatan(x + noise.nextFloat(NOISE_GAIN));
+                // fade over filter poles from 3dB/oct (1P) => 48dB/oct (5P)
+                sx = fade5(s1, s2, s3, s4, s5, slope);
 
-        float y = bx * (1 + drive * 40);
+                // saturate and add very low noise to have self oscillation with no input and high res
+                s0 = fastatan(u + r);
 
-        if (fabs(y) > 1) {
-            lightValue = (lightValue + fabs(y) / 5) / 2;
-        } else {
-            lightValue *= 0.99;
+                v = sx * overdrive;
+
+                T a = vmAbs(v);
+                light = vmSelectLess(T(1.f), a, (light + a * 0.2f) * 0.5f, light * 0.99f);
+
+                // overdrive with fast atan, which folds back the waves at high input and creates a noisy bright sound
+                v = fastatan(v);
+
+                for (int c = 0; c < LANES; c++) {
+                    data[m * LANES + c] = lane(v, c);
+                }
+            }
         }
 
+        rs.downsampleFrames(data, frames, len);
 
-        // overdrive with fast atan, which folds back the waves at high input and creates a noisy bright sound
-        rs->data[LOWPASS][i] = fastatan(y);
+        for (int j = 0; j < len * LANES; j++) {
+            out[i * LANES + j] = frames[j] * lane(gain, j % LANES);
+        }
     }
 
-    lpOut = rs->getDownsampled(LOWPASS) * (INPUT_GAIN / (drive * 20 + 1) * (quadraticBipolar(drive * 3) + 1));
+    b0 = flushDenormal(s0);
+    b1 = flushDenormal(s1);
+    b2 = flushDenormal(s2);
+    b3 = flushDenormal(s3);
+    b4 = flushDenormal(s4);
+    b5 = flushDenormal(s5);
+    bx = flushDenormal(sx);
+    lightValue = flushDenormal(light);
 }
 
 
@@ -69,7 +151,8 @@ void LadderFilter::process() {
  * @brief Return cutoff frequency in the range of 0..1
  * @return
  */
-float LadderFilter::getFrequency() const {
+template<typename T>
+const T &BasicLadderFilter<T>::getFrequency() const {
     return frequency;
 }
 
@@ -78,24 +161,24 @@ float LadderFilter::getFrequency() const {
  * @brief Update cutoff frequency in the range of 0..1
  * @param frequency
  */
-void LadderFilter::setFrequency(float frequency) {
-    if (LadderFilter::frequency != frequency) {
-        LadderFilter::frequency = frequency;
-        // translate frequency to logarithmic scale
-        freqHz = 20.f * powf(1000.f, frequency);
-        freqExp = clamp(freqHz * (1.f / (sr * OVERSAMPLE / 2.f)), 0.f, 0.9f);
+template<typename T>
+void BasicLadderFilter<T>::setFrequency(const T &frequency) {
+    BasicLadderFilter::frequency = frequency;
 
-        updateResExp();
-        invalidate();
-    }
+    // translate frequency to logarithmic scale
+    freqHz = 20.f * vpow(1000.f, frequency);
+
+    updateFreqExp();
+    invalidate();
 }
 
 
 /**
- * @brief Update resonance factor
+ * @brief Update frequency factor relative to the internal sample rate
  */
-void LadderFilter::updateResExp() {
-    resExp = clamp(resonance, 0.f, 1.5f);
+template<typename T>
+void BasicLadderFilter<T>::updateFreqExp() {
+    freqExp = clampLanes(freqHz * (1.f / (sr * rs.getFactor() / 2.f)), 0.f, 0.9f);
 }
 
 
@@ -103,7 +186,8 @@ void LadderFilter::updateResExp() {
  * @brief Get resonance
  * @return
  */
-float LadderFilter::getResonance() const {
+template<typename T>
+const T &BasicLadderFilter<T>::getResonance() const {
     return resExp;
 }
 
@@ -112,13 +196,57 @@ float LadderFilter::getResonance() const {
  * @brief Set resonance
  * @param resonance
  */
-void LadderFilter::setResonance(float resonance) {
-    if (LadderFilter::resonance != resonance) {
-        LadderFilter::resonance = resonance;
+template<typename T>
+void BasicLadderFilter<T>::setResonance(const T &resonance) {
+    resExp = clampLanes(resonance, 0.f, 1.5f);
+    invalidate();
+}
+
+
+/**
+ * @brief Change the factor of internal oversampling, 1 runs the filter at host rate
+ * @param factor Factor or RS_AUTO_FACTOR to derive it from the sample rate
+ */
+template<typename T>
+void BasicLadderFilter<T>::setOversampling(int factor) {
+    autoOversampling = factor == RS_AUTO_FACTOR;
+    factor = resolveOversampling(factor, sr, TARGET_RATE);
+
+    if (factor == rs.getFactor()) return;
+
+    rs.setFactor(factor);
+
+    updateFreqExp();
+    invalidate();
+    settle();
+}
+
+
+/**
+ * @brief Update sample rate, the automatic factor follows the new rate
+ * @param sr
+ */
+template<typename T>
+void BasicLadderFilter<T>::setSamplerate(float sr) {
+    DSPEffect::setSamplerate(sr);
 
-        updateResExp();
-        invalidate();
+    if (autoOversampling) {
+        rs.setFactor(resolveOversampling(RS_AUTO_FACTOR, sr, TARGET_RATE));
     }
+
+    updateFreqExp();
+    invalidate();
+    settle();
+}
+
+
+/**
+ * @brief Get the factor of internal oversampling
+ * @return
+ */
+template<typename T>
+int BasicLadderFilter<T>::getOversampling() {
+    return rs.getFactor();
 }
 
 
@@ -126,22 +254,19 @@ void LadderFilter::setResonance(float resonance) {
  * @brief Get overdrive
  * @return
  */
-float LadderFilter::getDrive() const {
+template<typename T>
+const T &BasicLadderFilter<T>::getDrive() const {
     return drive;
 }
 
 
 /**
- * @brief Set overdrive
+ * @brief Set overdrive, it only scales the signal and leaves the coefficients alone
  * @param drive
  */
-void LadderFilter::setDrive(float drive) {
-    if (LadderFilter::drive != drive) {
-        LadderFilter::drive = clamp(drive, 0.f, 1.f);
-
-        updateResExp();
-        invalidate();
-    }
+template<typename T>
+void BasicLadderFilter<T>::setDrive(const T &drive) {
+    BasicLadderFilter::drive = clampLanes(drive, 0.f, 1.f);
 }
 
 
@@ -149,10 +274,9 @@ void LadderFilter::setDrive(float drive) {
  * @brief Set input channel with sample
  * @param in
  */
-void LadderFilter::setIn(float in) {
-    float x = clamp(in / INPUT_GAIN, -0.8f, 0.8f);
-
-    LadderFilter::in = x;
+template<typename T>
+void BasicLadderFilter<T>::setIn(const T &in) {
+    BasicLadderFilter::in = in;
 }
 
 
@@ -160,7 +284,8 @@ void LadderFilter::setIn(float in) {
  * @brief Get lowpass output
  * @return
  */
-float LadderFilter::getLpOut() {
+template<typename T>
+const T &BasicLadderFilter<T>::getLpOut() const {
     return lpOut;
 }
 
@@ -169,7 +294,8 @@ float LadderFilter::getLpOut() {
  * @brief Get frequency of cutoff in Hz
  * @return
  */
-float LadderFilter::getFreqHz() const {
+template<typename T>
+const T &BasicLadderFilter<T>::getFreqHz() const {
     return freqHz;
 }
 
@@ -178,7 +304,8 @@ float LadderFilter::getFreqHz() const {
  * @brief Get filter slope
  * @return
  */
-float LadderFilter::getSlope() const {
+template<typename T>
+float BasicLadderFilter<T>::getSlope() const {
     return slope;
 }
 
@@ -187,8 +314,9 @@ float LadderFilter::getSlope() const {
  * @brief Set filter slope
  * @param slope
  */
-void LadderFilter::setSlope(float slope) {
-    LadderFilter::slope = clamp(slope, 0.f, 4.f);
+template<typename T>
+void BasicLadderFilter<T>::setSlope(float slope) {
+    BasicLadderFilter::slope = clamp(slope, 0.f, 4.f);
 }
 
 
@@ -196,7 +324,8 @@ void LadderFilter::setSlope(float slope) {
  * @brief Get the current light value for overload
  * @return
  */
-float LadderFilter::getLightValue() const {
+template<typename T>
+const T &BasicLadderFilter<T>::getLightValue() const {
     return lightValue;
 }
 
@@ -205,11 +334,34 @@ float LadderFilter::getLightValue() const {
  * @brief Set value for overload
  * @param lightValue
  */
-void LadderFilter::setLightValue(float lightValue) {
-    LadderFilter::lightValue = lightValue;
+template<typename T>
+void BasicLadderFilter<T>::setLightValue(const T &lightValue) {
+    BasicLadderFilter::lightValue = lightValue;
 }
 
 
-LadderFilter::LadderFilter(float sr) : DSPEffect(sr) {
-    rs = new Resampler<1>(OVERSAMPLE, 8);
+template<typename T>
+BasicLadderFilter<T>::BasicLadderFilter(float sr) :
+        DSPEffect(sr), rs(OVERSAMPLE, 8, UPSAMPLE_POLYPHASE, DOWNSAMPLE_HALFBAND, RS_ANY_FACTOR) {
+    frequency = 0.f;
+    freqHz = 20.f;
+    resExp = 0.f;
+    drive = 0.f;
+    slope = 0.f;
+    in = 0.f;
+    lpOut = 0.f;
+
+    init();
+
+    updateFreqExp();
+    invalidate();
+    settle();
+}
+
+
+/* the single voice filter and the SSE / AVX wide voice packs */
+template struct BasicLadderFilter<float>;
+template struct BasicLadderFilter<Float4>;
+template struct BasicLadderFilter<Float8>;
+
 }
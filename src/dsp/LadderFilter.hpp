@@ -1,15 +1,31 @@
 #pragma once
 
 
+#include <algorithm>
 #include "DSPEffect.hpp"
+#include "DSPSystem.hpp"
+#include "DSPLanes.hpp"
+#include "DSPVecMath.hpp"
 #include "engine.hpp"
 #include "DSPMath.hpp"
 
 namespace dsp {
 
-struct LadderFilter : DSPEffect {
-
-    static const int OVERSAMPLE = 4;                // factor of internal oversampling
+/**
+ * @brief Ladder filter over the sample type T
+ *
+ * T is float for a single voice or FloatLanes<N> for N independent voices, which run in the same
+ * instructions. Cutoff, resonance and drive are set per voice, the slope is shared by all voices.
+ * Blocks are passed as interleaved frames of N voices, one Resampler<N> filters all of them.
+ *
+ * @tparam T float or FloatLanes<N>
+ */
+template<typename T>
+struct BasicLadderFilter : DSPEffect {
+
+    static const int LANES = LaneCount<T>::value;
+    static const int OVERSAMPLE = 4;                // default factor of internal oversampling
+    static constexpr float TARGET_RATE = OVERSAMPLE * RS_REFERENCE_RATE;    // internal rate for automatic oversampling
     static constexpr float NOISE_GAIN = 10e-10f;    // internal noise gain used for self-oscillation
     static constexpr float INPUT_GAIN = 20.f;       // input level
 
@@ -18,56 +34,89 @@ struct LadderFilter : DSPEffect {
     };
 
 private:
-    float f, p, q;
-    float b0, b1, b2, b3, b4, b5, bx;
-    float t1, t2;
-    float freqExp, freqHz, frequency, resExp, resonance, drive, slope;
-    float in, lpOut;
-    float lightValue;
-
-    Resampler<1> *rs;
+    T f, p, q;
+    T fTarget, pTarget, qTarget;
+    int glide;
+    T b0, b1, b2, b3, b4, b5, bx;
+    T freqExp, freqHz, frequency, resExp, drive;
+    float slope;
+    T in, lpOut;
+    T lightValue;
+
+    Resampler<LANES> rs;
+    bool autoOversampling = false;
     Noise noise;
 
-    void updateResExp();
+    /* interleaved frames at host and internal rate */
+    double frames[RS_BUFFER_SIZE * LANES];
+    double up[RS_BUFFER_SIZE * LANES];
+    double data[RS_BUFFER_SIZE * LANES];
+    float rnd[RS_BUFFER_SIZE * LANES];
+
+    void updateFreqExp();
 
 public:
 
-    LadderFilter(float sr);
+    explicit BasicLadderFilter(float sr);
 
 
     void init() override {
-        f = 0;
-        p = 0;
-        q = 0;
-        b0 = 0;
-        b1 = 0;
-        b2 = 0;
-        b3 = 0;
-        b4 = 0;
-        b5 = 0;
-        bx = 0;
-        t1 = 0;
-        t2 = 0;
-        lightValue = 0.0f;
+        f = 0.f;
+        p = 0.f;
+        q = 0.f;
+        fTarget = 0.f;
+        pTarget = 0.f;
+        qTarget = 0.f;
+        glide = 0;
+        b0 = 0.f;
+        b1 = 0.f;
+        b2 = 0.f;
+        b3 = 0.f;
+        b4 = 0.f;
+        b5 = 0.f;
+        bx = 0.f;
+        lightValue = 0.f;
     }
 
 
     void invalidate() override;
+    void settle();
     void process() override;
+    void processBlock(const float *in, float *out, int n) override;
+    void setSamplerate(float sr) override;
+
+    void setOversampling(int factor);
+    int getOversampling();
+
+
+    /**
+     * @brief Switch the oversampling filters to the low latency IIR cascade
+     * @param lowLatency
+     */
+    void setLowLatency(bool lowLatency) {
+        rs.setLowLatency(lowLatency);
+    }
+
 
-    float getFrequency() const;
-    void setFrequency(float frequency);
-    float getResonance() const;
-    void setResonance(float resonance);
-    float getDrive() const;
-    void setDrive(float drive);
-    float getFreqHz() const;
+    const T &getFrequency() const;
+    void setFrequency(const T &frequency);
+    const T &getResonance() const;
+    void setResonance(const T &resonance);
+    const T &getDrive() const;
+    void setDrive(const T &drive);
+    const T &getFreqHz() const;
 
     float getSlope() const;
     void setSlope(float slope);
-    void setIn(float in);
-    float getLpOut();
-    float getLightValue() const;
-    void setLightValue(float lightValue);
+    void setIn(const T &in);
+    const T &getLpOut() const;
+    const T &getLightValue() const;
+    void setLightValue(const T &lightValue);
 };
-}
\ No newline at end of file
+
+
+typedef BasicLadderFilter<float> LadderFilter;
+typedef BasicLadderFilter<Float4> LadderFilter4;
+typedef BasicLadderFilter<Float8> LadderFilter8;
+
+}
@@ -1,41 +1,67 @@
 #include "Lockhart.hpp"
-#include "LambertW.h"
+#include "WrightOmega.hpp"
 
 using namespace dsp;
 
 
 /**
- * @brief TODO: optimized lambert function
+ * @brief Antiderivative of the stage transfer function
  * @param x
  * @return
  */
-double lambertopt(double x) {
-    /*if (x > 7.6667) {
-        return log(x) - log(log(x));
-    }*/
+double LockhartWFStage::antiderivative(double x) const {
+    // W(d * e^(l*b*x)) is evaluated as omega(log(d) + l*b*x)
+    double ln = wrightOmega(logd + sign(x) * b * x);
 
-    return log(x + 1);
-//    return LambertW<0>(x);
+    return (0.5 * LOCKHART_VT / b) * (ln * (ln + 2.)) - 0.5 * a * x * x;
+}
+
+
+/**
+ * @brief Stage transfer function without anti-aliasing
+ * @param x
+ * @return
+ */
+double LockhartWFStage::transfer(double x) const {
+    double l = sign(x);
+    double ln = wrightOmega(logd + l * b * x);
+
+    return l * LOCKHART_VT * ln - a * x;
+}
+
+
+/**
+ * @brief Switch between direct evaluation and the shared antiderivative table, only swaps the pointer
+ *        as the table is built with the first wavefolder
+ * @param tabulated
+ */
+void LockhartWFStage::setTabulated(bool tabulated) {
+    table = tabulated ? &getTable() : nullptr;
+}
+
+
+/**
+ * @brief Table shared by all stages, built by the constructor of the first wavefolder
+ * @return
+ */
+const ADAATable &LockhartWFStage::getTable() {
+    static const ADAATable table(LockhartWFStage(), LOCKHART_TABLE_RANGE, LOCKHART_TABLE_RESOLUTION);
+    return table;
 }
 
 
 double LockhartWFStage::compute(double x) {
     double out;
-    double l, u, ln, fn, xn;
+    bool lookup = table != nullptr && table->contains(x);
 
     // Compute Antiderivative
-    l = sign(x);
-    u = d * pow(M_E, l * b * x);
-    ln = dsp::LambertW<0>(u);
-    fn = (0.5 * LOCKHART_VT / b) * (ln * (ln + 2.)) - 0.5 * a * x * x;
+    double fn = lookup ? table->antiderivative(x) : antiderivative(x);
 
     // Check for ill-conditioning
     if (abs(x - xn1) < LOCKHART_THRESHOLD) {
         // Compute Averaged Wavefolder Output
-        xn = 0.5 * (x + xn1);
-        u = d * pow(M_E, l * b * xn);
-        ln = dsp::LambertW<0>(u);
-        out = l * LOCKHART_VT * ln - a * xn;
+        double xn = 0.5 * (x + xn1);
+        out = lookup ? table->transfer(xn) : transfer(xn);
 
     } else {
         // Apply AA Form
@@ -49,17 +75,19 @@ double LockhartWFStage::compute(double x) {
 
 
 LockhartWFStage::LockhartWFStage() {
-    fn1 = 0;
-    xn1 = 0;
-
     a = 2. * LOCKHART_RL / LOCKHART_R;
     b = (LOCKHART_R + 2. * LOCKHART_RL) / (LOCKHART_VT * LOCKHART_R);
-    d = (LOCKHART_RL * LOCKHART_Is) / LOCKHART_VT;
+    logd = log((LOCKHART_RL * LOCKHART_Is) / LOCKHART_VT);
+
+    /* start at rest, F(0) is not zero */
+    xn1 = 0;
+    fn1 = antiderivative(0.);
 }
 
 
 void LockhartWavefolder::init() {
-    dsp::WaveShaper::rs = new dsp::Resampler<1>(1);
+    WaveShaper::init();
+    tanh1.init();
 }
 
 
@@ -86,8 +114,8 @@ double LockhartWavefolder::compute(double x) {
     in = lh3.compute(in);
     in = lh4.compute(in);
 
-    in = tanh1->next(in) * 2.f;
-    //if (blockDC) in = dc->filter(in);
+    in = tanh1.next(in) * 2.f;
+    //if (blockDC) in = dc.filter(in);
 
     out = in * 10;
 
@@ -95,8 +123,10 @@ double LockhartWavefolder::compute(double x) {
 }
 
 
-LockhartWavefolder::LockhartWavefolder(float sr) : WaveShaper(sr) {
+LockhartWavefolder::LockhartWavefolder(float sr) : WaveShaper(sr), tanh1(sr, 1) {
+    /* build the table here and not on the audio thread when it is switched on */
+    LockhartWFStage::getTable();
+
     init();
-    tanh1 = new HQTanh(sr, 1);
 }
 
@@ -2,6 +2,7 @@
 
 #include "WaveShaper.hpp"
 #include "HQTrig.hpp"
+#include "ADAATable.hpp"
 
 // constants for Lockhart waveshaper model
 #define LOCKHART_RL 7.5e3
@@ -10,6 +11,10 @@
 #define LOCKHART_Is 10e-16
 #define LOCKHART_THRESHOLD 10e-10
 
+// antiderivative table, covers the stage input at full gain and bias
+#define LOCKHART_TABLE_RANGE 16.
+#define LOCKHART_TABLE_RESOLUTION 128
+
 
 namespace dsp {
 
@@ -20,12 +25,18 @@ struct LockhartWFStage {
 private:
 
     double fn1, xn1;
-    double a, b, d;
+    double a, b, logd;
+    const ADAATable *table = nullptr;
 
 public:
 
     LockhartWFStage();
 
+    static const ADAATable &getTable();
+
+    double antiderivative(double x) const;
+    double transfer(double x) const;
+    void setTabulated(bool tabulated);
     double compute(double x);
 };
 
@@ -37,6 +48,7 @@ struct LockhartWavefolder : WaveShaper {
 
 private:
     LockhartWFStage lh1, lh2, lh3, lh4;
+    HQTanh tanh1;
 
 public:
     explicit LockhartWavefolder(float sr);
@@ -45,6 +57,19 @@ public:
     void invalidate() override;
     void process() override;
     double compute(double x) override;
+
+
+    /**
+     * @brief Look up the stages in the precomputed antiderivative table instead of solving the
+     *        diode equation per sample
+     * @param tabulated
+     */
+    void setTabulated(bool tabulated) {
+        lh1.setTabulated(tabulated);
+        lh2.setTabulated(tabulated);
+        lh3.setTabulated(tabulated);
+        lh4.setTabulated(tabulated);
+    }
 };
 
 }
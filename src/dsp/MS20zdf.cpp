@@ -1,22 +1,39 @@
+#include <algorithm>
 #include "MS20zdf.hpp"
+#include "DSPVecMath.hpp"
 
 using namespace dsp;
 
 
 /**
- * @brief Calculate prewarped vars on parameter change
+ * @brief Calculate prewarped vars on parameter change, the filter glides to them over the
+ *        next control block
  */
 void MS20zdf::invalidate() {
     // translate frequency to logarithmic scale
     //  freqHz = 20.f * powf(860.f, param[FREQUENCY].value) - 20.f;
-    freqHz = 20.f * powf(950.f, param[FREQUENCY].value) - 20.f;
+    freqHz = 20.f * vpow(950.f, param[FREQUENCY].value) - 20.f;
 
-    b = tanf(freqHz * (float) M_PI / sr / OVERSAMPLE);
-    g = b / (1 + b);
+    /* keep the prewarped cutoff below nyquist of the internal rate */
+    float srOS = sr * rs.getFactor();
+    b = vtan(fminf(freqHz, 0.45f * srOS) * (float) M_PI / srOS);
+    gTarget = b / (1 + b);
 
     /* use shifted negative cubic shape for logarithmic like shaping of the peak parameter */
-    k = 2.f * cubicShape(param[PEAK].value) * 1.0001f;
+    kTarget = 2.f * cubicShape(param[PEAK].value) * 1.0001f;
+
+    glide = DSP_CONTROL_BLOCK;
+}
+
+
+/**
+ * @brief Jump to the current coefficients without gliding
+ */
+void MS20zdf::settle() {
+    g = gTarget;
+    k = kTarget;
     g2 = g * g;
+    glide = 0;
 }
 
 
@@ -24,38 +41,98 @@ void MS20zdf::invalidate() {
  * @brief Proccess one sample of filter
  */
 void MS20zdf::process() {
-    //rs.next(IN, input[IN].value);
-    rs->doUpsample(IN, input[IN].value);
+    processBlock(&input[IN].value, &output[OUT].value, 1);
+}
+
+
+/**
+ * @brief Filter a block of samples, the feedback state is kept in locals for the whole block
+ * @param in Input samples
+ * @param out Lowpass output
+ * @param n Number of samples
+ */
+void MS20zdf::processBlock(const float *in, float *out, int n) {
+    double buffer[RS_BUFFER_SIZE];
+    double *x = rs.getUpsampled(IN);
+    double *data = rs.data[IN];
+
+    int factor = rs.getFactor();
+    int blockSize = rs.getBlockSize();
 
     float s1, s2;
     float gain = quadraticBipolar(param[DRIVE].value) * DRIVE_GAIN + 1.f;
     float type = param[TYPE].value;
-    float x = 0;
+    float norm = 1.f / (g2 * k - g * k + 1.f);
+    float fb = ky, v = y;
+
+    /* split into chunks which fit into the resampler buffer */
+    for (int i = 0; i < n; i += blockSize) {
+        int len = std::min(blockSize, n - i);
+
+        for (int j = 0; j < len; j++) {
+            buffer[j] = in[i + j];
+        }
+
+        rs.upsampleBlock(IN, buffer, x, len);
 
-    for (int i = 0; i < rs->getFactor(); i++) {
-        x = rs->getUpsampled(IN)[i];
+        for (int j = 0, m = 0; j < len; j++) {
+            /* control rate parameters, the coefficients glide between the control blocks */
+            if (updateParams()) {
+                gain = quadraticBipolar(param[DRIVE].value) * DRIVE_GAIN + 1.f;
+            }
 
-        zdf1.set(x - ky, g);
-        s1 = zdf1.s;
+            if (glide > 0) {
+                g += (gTarget - g) / glide;
+                k += (kTarget - k) / glide;
+                g2 = g * g;
+                norm = 1.f / (g2 * k - g * k + 1.f);
+                glide--;
+            }
 
-        zdf2.set(zdf1.y + ky, g);
-        s2 = zdf2.s;
+            for (int l = 0; l < factor; l++) {
+                float u = x[m];
 
-        y = 1.f / (g2 * k - g * k + 1.f) * (g2 * x + g * s1 + s2);
+                zdf1.set(u - fb, g);
+                s1 = zdf1.s;
 
-        ky = k * fastatan(y / 70.f) * 70.f;
+                zdf2.set(zdf1.y + fb, g);
+                s2 = zdf2.s;
 
-        if (type > 0) {
-            rs->data[IN][i] = atanShaper(gain * y / 10.f) * 10.f;
-        } else {
-            rs->data[IN][i] = fastatan(gain * y / 10.f) * 10.f;
+                v = norm * (g2 * u + g * s1 + s2);
 
+                fb = k * fastatan(v / 70.f) * 70.f;
+
+                if (type > 0) {
+                    data[m++] = atanShaper(gain * v / 10.f) * 10.f;
+                } else {
+                    data[m++] = fastatan(gain * v / 10.f) * 10.f;
+                }
+            }
+        }
+
+        rs.downsampleBlock(IN, data, buffer, len);
+
+        for (int j = 0; j < len; j++) {
+            out[i + j] = buffer[j];
         }
     }
 
-    float out = rs->getDownsampled(IN);
+    ky = fb;
+    y = v;
+}
+
 
-    output[OUT].value = out;
+/**
+ * @brief Update sample rate, the automatic factor follows the new rate
+ * @param sr
+ */
+void MS20zdf::updateSampleRate(float sr) {
+    if (autoOversampling) {
+        rs.setFactor(resolveOversampling(RS_AUTO_FACTOR, sr, TARGET_RATE));
+    }
+
+    DSPSystem::updateSampleRate(sr);
+    settle();
 }
 
 
@@ -63,7 +140,14 @@ void MS20zdf::process() {
  * @brief Inherit constructor
  * @param sr sample rate
  */
-MS20zdf::MS20zdf(float sr) : DSPSystem(sr) {
-    rs = new Resampler<1>(OVERSAMPLE, 8);
+MS20zdf::MS20zdf(float sr) : DSPSystem(sr), rs(OVERSAMPLE, 8, UPSAMPLE_POLYPHASE, DOWNSAMPLE_HALFBAND, RS_ANY_FACTOR) {
+
+    /* cutoff and peak are modulated by CV, recompute their coefficients once per control block */
+    setControlRate(FREQUENCY);
+    setControlRate(PEAK);
+    setControlRate(DRIVE, SMOOTH_LINEAR, 0.005f);
+
+    invalidate();
+    settle();
 }
 
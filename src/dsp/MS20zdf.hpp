@@ -9,15 +9,15 @@ namespace dsp {
 /**
  * @brief
  */
-struct MS20TPT : DSPSystem2x1 {
+struct MS20TPT : DSPStaticSystem2x1<MS20TPT> {
     float s = 0;
     DSPDelay1 z;
 
 
-    void process() override {
+    inline void process() {
         float gx = input[IN1].value * input[IN2].value;
 
-        z.set(gx + z.get() + gx);
+        z.set(flushDenormal(gx + z.get() + gx));
         s = z.get();
     }
 };
@@ -26,13 +26,13 @@ struct MS20TPT : DSPSystem2x1 {
 /**
  * @brief Zero Delay Feedback
  */
-struct MS20ZDF : DSPSystem2x2 {
+struct MS20ZDF : DSPStaticSystem2x2<MS20ZDF> {
     float y = 0;
     float s = 0;
     MS20TPT tpt;
 
 
-    void process() override {
+    inline void process() {
         y = input[IN1].value * input[IN2].value + s;
 
         tpt.set(input[IN1].value - y, input[IN2].value);
@@ -46,7 +46,8 @@ struct MS20ZDF : DSPSystem2x2 {
  * @brief MS20 Filter class
  */
 struct MS20zdf : DSPSystem<1, 2, 4> {
-    static const int OVERSAMPLE = 4;                // factor of internal oversampling
+    static const int OVERSAMPLE = 4;                // default factor of internal oversampling
+    static constexpr float TARGET_RATE = OVERSAMPLE * RS_REFERENCE_RATE;    // internal rate for automatic oversampling
     static constexpr float DRIVE_GAIN = 20.f;       // max drive gain
 
     enum Inputs {
@@ -66,11 +67,14 @@ struct MS20zdf : DSPSystem<1, 2, 4> {
 
 private:
     float g = 0, g2 = 0, b = 0, k = 0;
+    float gTarget = 0, kTarget = 0;
+    int glide = 0;
     float ky = 0, y = 0;
     float freqHz = 0;
 
     MS20ZDF zdf1, zdf2;
-    Resampler<1> *rs;
+    Resampler<1> rs;
+    bool autoOversampling = false;
 
 public:
     explicit MS20zdf(float sr);
@@ -131,8 +135,41 @@ public:
     }
 
 
+    /**
+     * @brief Switch the oversampling filters to the low latency IIR cascade
+     * @param lowLatency
+     */
+    void setLowLatency(bool lowLatency) {
+        rs.setLowLatency(lowLatency);
+    }
+
+
+    /**
+     * @brief Change the factor of internal oversampling, 1 runs the filter at host rate
+     * @param factor Factor or RS_AUTO_FACTOR to derive it from the sample rate
+     */
+    void setOversampling(int factor) {
+        autoOversampling = factor == RS_AUTO_FACTOR;
+        factor = resolveOversampling(factor, sr, TARGET_RATE);
+
+        if (factor == rs.getFactor()) return;
+
+        rs.setFactor(factor);
+        invalidate();
+        settle();
+    }
+
+
+    int getOversampling() {
+        return rs.getFactor();
+    }
+
+
+    void updateSampleRate(float sr) override;
     void invalidate() override;
+    void settle();
     void process() override;
+    void processBlock(const float *in, float *out, int n) override;
 };
 
 
@@ -1,5 +1,6 @@
 #include "DSPMath.hpp"
 #include "Oscillator.hpp"
+#include "DSPVecMath.hpp"
 
 using namespace dsp;
 
@@ -8,8 +9,7 @@ using namespace dsp;
  * @brief Construct a Oscillator
  * @param sr SampleRate
  */
-DSPBLOscillator::DSPBLOscillator(float sr) : DSPSystem(sr) {
-    lfo = new DSPSineLFO(sr);
+DSPBLOscillator::DSPBLOscillator(float sr) : DSPSystem(sr), lfo(sr) {
     reset();
 }
 
@@ -19,6 +19,8 @@ DSPBLOscillator::DSPBLOscillator(float sr) : DSPSystem(sr) {
  */
 void DSPBLOscillator::invalidate() {
     incr = getPhaseIncrement(param[FREQUENCY].value);
+    phase.setIncrement(incr);
+    width = PhaseAccumulator::fromRadians(param[PULSEWIDTH].value * (float) M_PI);
     n = (int) floorf(BLIT_HARMONICS / param[FREQUENCY].value);
 }
 
@@ -30,14 +32,11 @@ void DSPBLOscillator::process() {
     updatePitch();
 
     /* phase locked loop */
-    phase = wrapTWOPI(incr + phase);
+    uint32_t p = phase.next();
 
-    /* pulse width */
-    float w = param[PULSEWIDTH].value * (float) M_PI;
-
-    /* get impulse train */
-    float blit1 = BLIT(n, phase);
-    float blit2 = BLIT(n, wrapTWOPI(w + phase));
+    /* get impulse train, the second one is shifted by the pulse width */
+    float blit1 = BLIT(n, p);
+    float blit2 = BLIT(n, p + width);
 
     /* feed integrator */
     int1.add(blit1, incr);
@@ -62,10 +61,10 @@ void DSPBLOscillator::process() {
     output[TRI].value = beta * 5.f;
 
     /* compute sine */
-    output[SINE].value = fastSin(phase) * 5.f;
+    output[SINE].value = fastSin(phase.getRadians()) * 5.f;
 
     /* compute noise: act as S&H in LFO mode, update next random only every cycle */
-    if (!lfoMode || phase - incr <= -M_PI)
+    if (!lfoMode || phase.wrapped())
         output[NOISE].value = noise.nextFloat(10.f) - 5.f;
 
 }
@@ -74,7 +73,8 @@ void DSPBLOscillator::process() {
 void DSPBLOscillator::reset() {
     param[FREQUENCY].value = 0.f;
     param[PULSEWIDTH].value = 1.f;
-    phase = 0.f;
+    phase.reset();
+    width = 0;
     incr = 0.f;
     detune = noise.nextFloat(DETUNE_AMOUNT);
     drift = 0.f;
@@ -82,9 +82,9 @@ void DSPBLOscillator::reset() {
     warmupTau = sr * 1.5f;
     tick = round(sr * 0.7f);
 
-    lfo->reset();
-    lfo->setPhase(noise.nextFloat(TWOPI));
-    lfo->setFrequency(DRIFT_FREQ + noise.nextFloat(DRIFT_VARIANZ));
+    lfo.reset();
+    lfo.setPhase(noise.nextFloat(TWOPI));
+    lfo.setFrequency(DRIFT_FREQ + noise.nextFloat(DRIFT_VARIANZ));
 
     n = 0;
 
@@ -116,13 +116,13 @@ void DSPBLOscillator::updatePitch() {
     if (tick++ < sr * 30) {
         if (tick < sr * 1.8f) {
             tick += 6; // accelerated detune
-            warmup = 1 - powf((float) M_E, -(tick / warmupTau));
+            warmup = 1 - vexp(-(tick / warmupTau));
         } else
-            warmup = 1 - powf((float) M_E, -(tick / warmupTau));
+            warmup = 1 - vexp(-(tick / warmupTau));
     }
 
-    lfo->process();
-    drift = lfo->getSine() * DRIFT_AMOUNT;
+    lfo.process();
+    drift = lfo.getSine() * DRIFT_AMOUNT;
 
     float cv = input[VOCT1].value + input[VOCT2].value;
     float fm;
@@ -143,8 +143,8 @@ void DSPBLOscillator::updatePitch() {
     }
 
     /* optimize the usage of expensive exp function and other computations */
-    float coeff = (_oct != oct) ? powf(2.f, oct) : _coeff;
-    float base = (_cv != cv) ? powf(2.f, cv) : _base;
+    float coeff = (_oct != oct) ? vexp2(oct) : _coeff;
+    float base = (_cv != cv) ? vexp2(cv) : _base;
     float biqufm = (_tune != tune + fm) ? quadraticBipolar(tune + fm) : _biqufm;
 
     if (lfoMode)
@@ -190,6 +190,6 @@ void DSPBLOscillator::setInputs(float voct1, float voct2, float fm, float tune,
  */
 void DSPBLOscillator::updateSampleRate(float sr) {
     DSPSystem::updateSampleRate(sr);
-    lfo->updateSampleRate(sr);
+    lfo.updateSampleRate(sr);
 }
 
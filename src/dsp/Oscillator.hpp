@@ -27,7 +27,7 @@ struct DSPSineLFO : DSPSystem<0, 1, 1> {
     };
 
 private:
-    float frac, phase;
+    PhaseAccumulator phase;
 
 public:
 
@@ -47,13 +47,13 @@ public:
 
 
     void invalidate() override {
-        frac = TWOPI / sr * param[FREQ].value;
+        phase.setIncrement(TWOPI / sr * param[FREQ].value);
     }
 
 
     void process() override {
-        phase = wrapTWOPI(phase + frac);
-        output[SINE].value = fastSin(phase);
+        phase.next();
+        output[SINE].value = fastSin(phase.getRadians());
     }
 
 
@@ -63,12 +63,12 @@ public:
 
 
     void setPhase(float phase) {
-        DSPSineLFO::phase = phase;
+        DSPSineLFO::phase.setRadians(phase);
     }
 
 
     void reset() {
-        phase = 0;
+        phase.reset();
     }
 
 };
@@ -153,7 +153,8 @@ struct DSPBLOscillator : DSPSystem<4, 6, 10> {
     };
 
 private:
-    float phase;     // current phase
+    PhaseAccumulator phase; // current phase
+    uint32_t width;  // pulse width as phase offset
     float incr;      // current phase increment for PLL
     float detune;    // analogue detune
     float drift;     // oscillator drift
@@ -168,7 +169,7 @@ private:
     Integrator int2;
     Integrator int3;
 
-    DSPSineLFO *lfo;
+    DSPSineLFO lfo;
 
 
     void reset();
@@ -3,15 +3,14 @@
 using namespace dsp;
 
 
-Overdrive::Overdrive(float sr) : WaveShaper(sr) {
+Overdrive::Overdrive(float sr) : WaveShaper(sr, 4), tanh1(sr, 1) {
     init();
-    noise = new Noise;
-    tanh1 = new HQTanh(sr, 1);
 }
 
 
 void Overdrive::init() {
-    WaveShaper::rs = new Resampler<1>(4);
+    WaveShaper::init();
+    tanh1.init();
 }
 
 
@@ -32,7 +31,7 @@ double Overdrive::compute(double x) {
 
     in *= OVERDRIVE_GAIN;
 
-    in = tanh1->next(in * 1.5) * 1.5;
+    in = tanh1.next(in * 1.5) * 1.5;
 
     double a = clampd(gain / 20, 0., .999999);
 
@@ -40,9 +39,16 @@ double Overdrive::compute(double x) {
     in = (1 + k) * (in) / (1 + k * abs(in));
 
     in *= 1 / OVERDRIVE_GAIN * 0.3;
-    // if (blockDC) in = dc->filter(in);
+    // if (blockDC) in = dc.filter(in);
 
     out = in;
 
     return out;
 }
+
+
+void Overdrive::computeBlock(double *x, int n) {
+    for (int i = 0; i < n; i++) {
+        x[i] = Overdrive::compute(x[i]);
+    }
+}
@@ -8,7 +8,7 @@ namespace dsp {
 
 struct Overdrive : WaveShaper {
 
-    Noise *noise;
+    HQTanh tanh1;
 
 
 public:
@@ -19,6 +19,7 @@ public:
     void invalidate() override;
     void process() override;
     double compute(double x) override;
+    void computeBlock(double *x, int n) override;
 
 };
 
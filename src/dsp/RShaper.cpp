@@ -3,14 +3,13 @@
 using namespace dsp;
 
 
-ReShaper::ReShaper(float sr) : WaveShaper(sr) {
+ReShaper::ReShaper(float sr) : WaveShaper(sr, 8, 16, UPSAMPLE_LINEAR, DOWNSAMPLE_HALFBAND, RS_ANY_FACTOR) {
     init();
-    noise = new Noise;
 }
 
 
 void ReShaper::init() {
-    WaveShaper::rs = new Resampler<1>(8, 16);
+    WaveShaper::init();
 }
 
 
@@ -34,9 +33,16 @@ double ReShaper::compute(double x) {
     in = in * (fabs(in) + a) / (in * in + (a - 1) * fabs(in) + 1);
 
     in *= 1 / RSHAPER_GAIN * 0.5;
-    if (blockDC) in = dc->filter(in);
+    if (blockDC) in = dc.filter(in);
 
     out = in;
 
     return out;
 }
+
+
+void ReShaper::computeBlock(double *x, int n) {
+    for (int i = 0; i < n; i++) {
+        x[i] = ReShaper::compute(x[i]);
+    }
+}
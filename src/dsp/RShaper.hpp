@@ -8,8 +8,6 @@ namespace dsp {
 
 struct ReShaper : WaveShaper {
 
-    Noise *noise;
-
 
 public:
 
@@ -19,6 +17,7 @@ public:
     void invalidate() override;
     void process() override;
     double compute(double x) override;
+    void computeBlock(double *x, int n) override;
 
 };
 
@@ -3,15 +3,14 @@
 using namespace dsp;
 
 
-Saturator::Saturator(float sr) : WaveShaper(sr) {
+Saturator::Saturator(float sr) : WaveShaper(sr), tanh1(sr, 4) {
     init();
-    noise = new Noise;
-    tanh1 = new HQTanh(sr, 4);
 }
 
 
 void Saturator::init() {
-    WaveShaper::rs = new Resampler<1>(1);
+    WaveShaper::init();
+    tanh1.init();
 }
 
 
@@ -32,10 +31,10 @@ double Saturator::compute(double x) {
 
     in *= SATURATOR_GAIN;
 
-    in = tanh1->next(in);
+    in = tanh1.next(in);
 
     in *= 1 / SATURATOR_GAIN * 0.3;
-    if (blockDC) in = dc->filter(in);
+    if (blockDC) in = dc.filter(in);
 
     out = in;
 
@@ -8,7 +8,7 @@ namespace dsp {
 
 struct Saturator : WaveShaper {
 
-    Noise *noise;
+    HQTanh tanh1;
 
 
 public:
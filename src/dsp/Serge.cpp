@@ -1,25 +1,65 @@
 #include "Serge.hpp"
-#include "LambertW.h"
+#include "WrightOmega.hpp"
 
 using namespace dsp;
 
+/**
+ * @brief Antiderivative of the stage transfer function
+ * @param x
+ * @return
+ */
+double SergeWFStage::antiderivative(double x) const {
+    // W(d * e^(l*x/(eta*Vt))) is evaluated as omega(log(d) + l*x/(eta*Vt))
+    double ln = wrightOmega(logd + (sign(x) * x) / (SERGE_ETA * SERGE_VT));
+
+    return SERGE_VT * SERGE_ETA * SERGE_ETA * SERGE_VT * (ln * (ln + 2)) - x * x / 2;
+}
+
+
+/**
+ * @brief Stage transfer function without anti-aliasing
+ * @param x
+ * @return
+ */
+double SergeWFStage::transfer(double x) const {
+    double l = sign(x);
+    double ln = wrightOmega(logd + (l * x) / (SERGE_VT * SERGE_ETA));
+
+    return 2 * l * SERGE_ETA * SERGE_VT * ln - x;
+}
+
+
+/**
+ * @brief Switch between direct evaluation and the shared antiderivative table, only swaps the pointer
+ *        as the table is built with the first wavefolder
+ * @param tabulated
+ */
+void SergeWFStage::setTabulated(bool tabulated) {
+    table = tabulated ? &getTable() : nullptr;
+}
+
+
+/**
+ * @brief Table shared by all stages, built by the constructor of the first wavefolder
+ * @return
+ */
+const ADAATable &SergeWFStage::getTable() {
+    static const ADAATable table(SergeWFStage(), SERGE_TABLE_RANGE, SERGE_TABLE_RESOLUTION);
+    return table;
+}
+
+
 double SergeWFStage::compute(double x) {
     double out;
-    double l, u, ln, fn, xn;
-
-    l = sign(x);
-    u = (SERGE_R1 * SERGE_IS) / (SERGE_ETA * SERGE_VT) * pow(M_E, (l * x) / (SERGE_ETA * SERGE_VT));
-    ln = dsp::LambertW<0>(u);
+    bool lookup = table != nullptr && table->contains(x);
 
-    fn = SERGE_VT * SERGE_ETA * SERGE_ETA * SERGE_VT * (ln * (ln + 2)) - x * x / 2;
+    double fn = lookup ? table->antiderivative(x) : antiderivative(x);
 
     // Check for ill-conditioning
     if (abs(x - xn1) < SERGE_THRESHOLD) {
         // Compute Averaged Wavefolder Output
-        xn = 0.5 * (x + xn1);
-        u = (SERGE_R1 * SERGE_IS) / (SERGE_ETA * SERGE_VT) * pow(M_E, (l * xn) / (SERGE_VT * SERGE_ETA));
-        ln = dsp::LambertW<0>(u);
-        out = 2 * l * SERGE_ETA * SERGE_VT * ln - xn;
+        double xn = 0.5 * (x + xn1);
+        out = lookup ? table->transfer(xn) : transfer(xn);
     } else {
         // Apply AA Form
         out = (fn - fn1) / (x - xn1);
@@ -33,19 +73,25 @@ double SergeWFStage::compute(double x) {
 
 
 SergeWFStage::SergeWFStage() {
-    fn1 = 0;
+    logd = log((SERGE_R1 * SERGE_IS) / (SERGE_ETA * SERGE_VT));
+
+    /* start at rest, F(0) is not zero */
     xn1 = 0;
+    fn1 = antiderivative(0.);
 }
 
 
-SergeWavefolder::SergeWavefolder(float sr) : WaveShaper(sr) {
+SergeWavefolder::SergeWavefolder(float sr) : WaveShaper(sr), tanh1(sr, 1) {
+    /* build the table here and not on the audio thread when it is switched on */
+    SergeWFStage::getTable();
+
     init();
-    tanh1 = new HQTanh(sr, 1);
 }
 
 
 void SergeWavefolder::init() {
-    dsp::WaveShaper::rs = new dsp::Resampler<1>(1);
+    WaveShaper::init();
+    tanh1.init();
 }
 
 
@@ -70,8 +116,8 @@ double SergeWavefolder::compute(double x) {
     in = sg5.compute(in);
     in = sg6.compute(in);
 
-    in = tanh1->next(in) * 3.f;
-    if (blockDC) in = dc->filter(in);
+    in = tanh1.next(in) * 3.f;
+    if (blockDC) in = dc.filter(in);
 
     out = in * 10;
 
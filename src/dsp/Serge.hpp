@@ -2,6 +2,7 @@
 
 #include "WaveShaper.hpp"
 #include "HQTrig.hpp"
+#include "ADAATable.hpp"
 
 #define SERGE_R1 33e3
 #define SERGE_IS 2.52e-9
@@ -10,14 +11,26 @@
 
 #define SERGE_THRESHOLD 10e-10
 
+// antiderivative table, covers the stage input at full gain and bias
+#define SERGE_TABLE_RANGE 22.
+#define SERGE_TABLE_RESOLUTION 64
+
 namespace dsp {
 
 struct SergeWFStage {
 private:
     double fn1, xn1;
+    double logd;
+    const ADAATable *table = nullptr;
 
 public:
     SergeWFStage();
+
+    static const ADAATable &getTable();
+
+    double antiderivative(double x) const;
+    double transfer(double x) const;
+    void setTabulated(bool tabulated);
     double compute(double x);
 };
 
@@ -27,7 +40,7 @@ struct SergeWavefolder : WaveShaper {
 private:
     SergeWFStage sg1, sg2, sg3, sg4, sg5, sg6;
     //   DCBlocker *dc = new DCBlocker(DCBLOCK_ALPHA);
-    HQTanh *tanh1;
+    HQTanh tanh1;
     bool blockDC = false;
 
 
@@ -38,6 +51,20 @@ public:
     void process() override;
     double compute(double x) override;
 
+
+    /**
+     * @brief Look up the stages in the precomputed antiderivative table instead of solving the
+     *        diode equation per sample
+     * @param tabulated
+     */
+    void setTabulated(bool tabulated) {
+        sg1.setTabulated(tabulated);
+        sg2.setTabulated(tabulated);
+        sg3.setTabulated(tabulated);
+        sg4.setTabulated(tabulated);
+        sg5.setTabulated(tabulated);
+        sg6.setTabulated(tabulated);
+    }
 };
 
 
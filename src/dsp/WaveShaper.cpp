@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include "WaveShaper.hpp"
 
 using namespace dsp;
@@ -60,25 +61,49 @@ const Vec &WaveShaper::getAmplitude() const {
 
 
 void WaveShaper::process() {
-    /* if no oversampling set up */
-    if (rs->getFactor() == 1) {
-        out = compute(in);
-        //debug("%f", out);
-        return;
-    }
+    processBlock(&in, &out, 1);
+}
+
 
-    rs->doUpsample(STD_CHANNEL, in);
+void WaveShaper::processBlock(const double *in, double *out, int n) {
+    double *x = rs.getUpsampled(STD_CHANNEL);
+    int blockSize = rs.getBlockSize();
 
-    for (int i = 0; i < rs->getFactor(); i++) {
-        double x = rs->getUpsampled(STD_CHANNEL)[i];
-        rs->data[STD_CHANNEL][i] = compute(x);
+    /* split into chunks which fit into the resampler buffer */
+    for (int i = 0; i < n; i += blockSize) {
+        int len = std::min(blockSize, n - i);
+
+        rs.upsampleBlock(STD_CHANNEL, &in[i], x, len);
+        computeBlock(x, len * rs.getFactor());
+        rs.downsampleBlock(STD_CHANNEL, x, &out[i], len);
     }
+}
+
 
-    out = rs->getDownsampled(STD_CHANNEL);
+void WaveShaper::processBlock(const float *in, float *out, int n) {
+    double x[RS_BUFFER_SIZE], y[RS_BUFFER_SIZE];
+
+    for (int i = 0; i < n; i += RS_BUFFER_SIZE) {
+        int len = std::min(RS_BUFFER_SIZE, n - i);
+
+        for (int j = 0; j < len; j++) {
+            x[j] = in[i + j];
+        }
+
+        processBlock(x, y, len);
+
+        for (int j = 0; j < len; j++) {
+            out[i + j] = (float) y[j];
+        }
+    }
 }
 
 
-WaveShaper::WaveShaper(float sr) : DSPEffect(sr) {}
+WaveShaper::WaveShaper(float sr, int factor, int quality, UpsamplingType upsampling, DownsamplingType downsampling,
+                       ResamplerFactors factors) :
+        DSPEffect(sr), rs(factor, quality, upsampling, downsampling, factors), targetRate(factor * RS_REFERENCE_RATE) {
+    WaveShaper::init();
+}
 
 
 bool WaveShaper::isBlockDC() const {
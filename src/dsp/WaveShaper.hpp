@@ -19,10 +19,11 @@ struct WaveShaper : DSPEffect {
     static constexpr double SHAPER_MAX_BIAS = 12.0; // +/- 5V
 
 protected:
-    Resampler<1> *rs;
+    Resampler<1> rs;
+    float targetRate;                       // internal rate for automatic oversampling
+    bool autoOversampling = false;
 
-    DCBlocker *dc = new DCBlocker(DCBLOCK_ALPHA);
-    HQTanh *tanh1;
+    DCBlocker dc{DCBLOCK_ALPHA};
     bool blockDC = false;
 
     double in, gain, bias, k;
@@ -31,7 +32,17 @@ protected:
 
 public:
 
-    WaveShaper(float sr);
+    /**
+     * @brief Constructor, the resampler is set up by the shaper and held inline
+     * @param sr Sample rate
+     * @param factor Default oversampling factor, also used for the automatic rate
+     * @param quality Filter taps per input sample
+     * @param upsampling Method used to create the up-sampled data
+     * @param downsampling Method used to decimate
+     * @param factors RS_ANY_FACTOR for shapers which are switched with setOversampling()
+     */
+    WaveShaper(float sr, int factor = 1, int quality = 4, UpsamplingType upsampling = UPSAMPLE_LINEAR,
+               DownsamplingType downsampling = DOWNSAMPLE_FIR, ResamplerFactors factors = RS_FIXED_FACTOR);
 
     double getIn() const;
     void setIn(double in);
@@ -50,7 +61,41 @@ public:
      * @return
      */
     double getOversampledRate() {
-        return sr * rs->getFactor();
+        return sr * rs.getFactor();
+    }
+
+
+    /**
+     * @brief Switch the oversampling filters to the low latency IIR cascade
+     * @param lowLatency
+     */
+    void setLowLatency(bool lowLatency) {
+        rs.setLowLatency(lowLatency);
+    }
+
+
+    /**
+     * @brief Change the factor of oversampling, 1 runs the shaper at host rate. Shapers built with
+     *        RS_FIXED_FACTOR keep their factor.
+     * @param factor Factor or RS_AUTO_FACTOR to derive it from the sample rate
+     */
+    void setOversampling(int factor) {
+        autoOversampling = factor == RS_AUTO_FACTOR;
+        rs.setFactor(resolveOversampling(factor, sr, targetRate));
+    }
+
+
+    void setSamplerate(float sr) override {
+        DSPEffect::setSamplerate(sr);
+
+        if (autoOversampling) {
+            rs.setFactor(resolveOversampling(RS_AUTO_FACTOR, sr, targetRate));
+        }
+    }
+
+
+    int getOversampling() {
+        return rs.getFactor();
     }
 
 
@@ -70,7 +115,18 @@ public:
     void process() override;
 
 
+    /**
+     * @brief Process a block of host samples, gain and bias are held for the whole block
+     * @param in Input samples
+     * @param out Output samples
+     * @param n Number of samples
+     */
+    void processBlock(const double *in, double *out, int n);
+    void processBlock(const float *in, float *out, int n) override;
+
+
     void init() override {
+        in = 0;
         gain = 0;
         out = 0;
         k = 0;
@@ -86,6 +142,20 @@ public:
      * @return Output sample
      */
     virtual double compute(double x) { return x; }
+
+
+    /**
+     * @brief Apply compute() in place to a block of oversampled data. Subclasses should override
+     *        this with a loop over their own compute() to get rid of the virtual call per sample
+     *
+     * @param x Oversampled block
+     * @param n Number of samples
+     */
+    virtual void computeBlock(double *x, int n) {
+        for (int i = 0; i < n; i++) {
+            x[i] = compute(x[i]);
+        }
+    }
 };
 
 
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cmath>
+#include "Horner.h"
+#include "DSPLanes.hpp"
+#include "DSPVecMath.hpp"
+
+/* bounds of the initial guess regions, see wrightOmegaGuess() */
+#define WRIGHTOMEGA_X1 0.3220834991691133   // log(1.38)
+#define WRIGHTOMEGA_X2 6.1
+
+/* below these arguments omega(x) equals exp(x) in the respective precision */
+#define WRIGHTOMEGA_EXP_LIMIT_F -18.f
+#define WRIGHTOMEGA_EXP_LIMIT_D -40.
+
+namespace dsp {
+
+/**
+ * @brief Initial guess for the Wright omega function, relative error below 3e-5
+ *
+ * Uses the Pade approximants of LambertW<0> below X2, the second one is written in x so it needs
+ * no exp/log, and the asymptotic series x - log(x) + ... above.
+ *
+ * @param x
+ * @return
+ */
+template<typename T>
+inline T wrightOmegaGuess(T x) {
+    if (x < T(WRIGHTOMEGA_X1)) {
+        T z = std::exp(x);
+
+        return z * HORNER4(T, z, 0.07066247420543414, 2.4326814530577687, 6.39672835731526, 4.663365025836821, 0.99999908757381) /
+               HORNER4(T, z, 1.2906660139511692, 7.164571775410987, 10.559985088953114, 5.66336307375819, 1);
+    }
+
+    if (x < T(WRIGHTOMEGA_X2)) {
+        T y = x - T(M_LN2 + 2);
+
+        return 2 + y * HORNER3(T, y, 0.00006979269679670452, 0.017110368846615806, 0.19338607770900237, 0.6666648896499793) /
+                   HORNER2(T, y, 0.0188060684652668, 0.23451269827133317, 1);
+    }
+
+    T l = std::log(x);
+    T ix = 1 / x;
+
+    return x - l + l * ix * (1 + ix * (T(0.5) * (l - 2) + ix * HORNER2(T, l, 1. / 3., -1.5, 1)));
+}
+
+
+/**
+ * @brief One step of the fourth order Householder (Fritsch) iteration on w + log(w) = x
+ * @param x Argument
+ * @param w Current estimate of omega(x)
+ * @param lw log(w)
+ * @return Refined estimate
+ */
+template<typename T>
+inline T wrightOmegaStep(T x, T w, T lw) {
+    T r = x - w - lw;
+    T w1 = 1 + w;
+    T q = w1 * (w1 + T(2. / 3.) * r);
+
+    return w * (1 + r / w1 * (q - T(0.5) * r) / (q - r));
+}
+
+
+/**
+ * @brief Wright omega function omega(x) = W(exp(x)), relative error below 3e-6
+ * @param x
+ * @return
+ */
+inline float wrightOmega(float x) {
+    if (x < WRIGHTOMEGA_EXP_LIMIT_F) {
+        return expf(x);
+    }
+
+    float w = wrightOmegaGuess(x);
+
+    return wrightOmegaStep(x, w, logf(w));
+}
+
+
+/**
+ * @brief Wright omega function omega(x) = W(exp(x)), relative error below 1e-14
+ *
+ * Replaces LambertW<0>(exp(x)) without forming the exponential, so large arguments can not overflow.
+ *
+ * @param x
+ * @return
+ */
+inline double wrightOmega(double x) {
+    if (x < WRIGHTOMEGA_EXP_LIMIT_D) {
+        return exp(x);
+    }
+
+    double w = wrightOmegaGuess(x);
+
+    return wrightOmegaStep(x, w, log(w));
+}
+
+
+/**
+ * @brief Lane-wise wrightOmega(float) on vexp() and vlog(), all guess regions are evaluated and
+ *        selected per lane, so the lanes never diverge
+ *
+ * Relative error below 3e-6 down to the exp limit, below it the error of vexp() applies.
+ */
+template<int LANES>
+inline FloatLanes<LANES> wrightOmega(const FloatLanes<LANES> &x) {
+    typedef FloatLanes<LANES> Lanes;
+
+    Lanes xc = vmMax(x, Lanes(WRIGHTOMEGA_EXP_LIMIT_F));
+    Lanes z = vexp(vmMin(xc, Lanes((float) WRIGHTOMEGA_X1)));
+    Lanes l = vlog(vmMax(xc, Lanes((float) WRIGHTOMEGA_X2)));
+
+    Lanes y = xc - (float) (M_LN2 + 2);
+    Lanes ix = 1.f / xc;
+
+    Lanes p1 = z * HORNER4(Lanes, z, 0.07066247420543414, 2.4326814530577687, 6.39672835731526, 4.663365025836821, 0.99999908757381) /
+               HORNER4(Lanes, z, 1.2906660139511692, 7.164571775410987, 10.559985088953114, 5.66336307375819, 1);
+    Lanes p2 = 2.f + y * HORNER3(Lanes, y, 0.00006979269679670452, 0.017110368846615806, 0.19338607770900237, 0.6666648896499793) /
+                     HORNER2(Lanes, y, 0.0188060684652668, 0.23451269827133317, 1);
+    Lanes as = xc - l + l * ix * (1.f + ix * (0.5f * (l - 2.f) + ix * HORNER2(Lanes, l, 1. / 3., -1.5, 1)));
+
+    Lanes w = vmSelectLess(xc, Lanes((float) WRIGHTOMEGA_X1), p1,
+                           vmSelectLess(xc, Lanes((float) WRIGHTOMEGA_X2), p2, as));
+
+    w = wrightOmegaStep(xc, w, vlog(w));
+
+    return vmSelectLess(x, Lanes(WRIGHTOMEGA_EXP_LIMIT_F), vexp(x), w);
+}
+
+}
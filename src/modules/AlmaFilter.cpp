@@ -38,30 +38,52 @@ struct AlmaFilter : LRModule {
         NUM_LIGHTS
     };
 
-    dsp::LadderFilter *filter = new dsp::LadderFilter(engineGetSampleRate());
+    dsp::LadderFilter filter{engineGetSampleRate()};
 
     LRBigKnob *frqKnob = NULL;
     LRMiddleKnob *peakKnob = NULL;
     LRMiddleKnob *driveKnob = NULL;
 
+    static const int DEFAULT_OVERSAMPLE = RS_AUTO_FACTOR;
+    int oversample = DEFAULT_OVERSAMPLE;
+
+    ControlRamp drive;
+
 
     AlmaFilter() : LRModule(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {}
 
 
-    void step() override;
+    json_t *toJson() override {
+        json_t *rootJ = json_object();
+
+        json_object_set_new(rootJ, JSON_OVERSAMPLE_KEY, json_integer(oversample));
+        return rootJ;
+    }
+
+
+    void fromJson(json_t *rootJ) override {
+        oversample = oversamplingFromJson(rootJ, DEFAULT_OVERSAMPLE);
+    }
+
+
+    void controlStep() override;
+    void audioStep() override;
     void onSampleRateChange() override;
 };
 
 
-void AlmaFilter::step() {
+void AlmaFilter::controlStep() {
     float frqcv = inputs[CUTOFF_CV_INPUT].value * 0.1f * quadraticBipolar(params[CUTOFF_CV_PARAM].value);
     float rescv = inputs[RESONANCE_CV_INPUT].value * 0.1f * quadraticBipolar(params[RESONANCE_CV_PARAM].value);
     float drvcv = inputs[DRIVE_CV_INPUT].value * 0.1f * quadraticBipolar(params[DRIVE_CV_PARAM].value);
 
-    filter->setFrequency(params[CUTOFF_PARAM].value + frqcv);
-    filter->setResonance(params[RESONANCE_PARAM].value + rescv);
-    filter->setDrive(params[DRIVE_PARAM].value + drvcv);
-    filter->setSlope(params[SLOPE_PARAM].value);
+    /* the coefficients are recomputed once per control step and glide there over the next control block */
+    filter.setFrequency(params[CUTOFF_PARAM].value + frqcv);
+    filter.setResonance(params[RESONANCE_PARAM].value + rescv);
+    drive.set(params[DRIVE_PARAM].value + drvcv);
+
+    filter.setSlope(params[SLOPE_PARAM].value);
+    filter.setOversampling(oversample);
 
 
     /* pass modulated parameter to knob widget for cv indicator */
@@ -75,22 +97,23 @@ void AlmaFilter::step() {
         driveKnob->setIndicatorValue(params[DRIVE_PARAM].value + drvcv);
     }
 
+    lights[OVERLOAD_LIGHT].value = filter.getLightValue();
+}
 
-    float y = inputs[FILTER_INPUT].value;
-
-    filter->setIn(y);
-    filter->process();
 
-    outputs[LP_OUTPUT].value = filter->getLpOut();
+void AlmaFilter::audioStep() {
+    filter.setDrive(drive.next());
 
+    filter.setIn(inputs[FILTER_INPUT].value);
+    filter.process();
 
-    lights[OVERLOAD_LIGHT].value = filter->getLightValue();
+    outputs[LP_OUTPUT].value = filter.getLpOut();
 }
 
 
 void AlmaFilter::onSampleRateChange() {
     Module::onSampleRateChange();
-    filter->setSamplerate(engineGetSampleRate());
+    filter.setSamplerate(engineGetSampleRate());
 }
 
 
@@ -99,6 +122,7 @@ void AlmaFilter::onSampleRateChange() {
  */
 struct AlmaFilterWidget : LRModuleWidget {
     AlmaFilterWidget(AlmaFilter *module);
+    void appendContextMenu(Menu *menu) override;
 };
 
 
@@ -154,4 +178,12 @@ AlmaFilterWidget::AlmaFilterWidget(AlmaFilter *module) : LRModuleWidget(module)
 }
 
 
+void AlmaFilterWidget::appendContextMenu(Menu *menu) {
+    AlmaFilter *almaFilter = dynamic_cast<AlmaFilter *>(module);
+    assert(almaFilter);
+
+    appendOversamplingMenu(menu, &almaFilter->oversample);
+}
+
+
 Model *modelAlmaFilter = Model::create<AlmaFilter, AlmaFilterWidget>("Lindenberg Research", "VCF", "Alma Ladder Filter", FILTER_TAG);
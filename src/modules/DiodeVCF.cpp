@@ -44,7 +44,7 @@ struct DiodeVCF : LRModule {
     void updateComponents();
 
     LRLCDWidget *lcd = new LRLCDWidget(12, "%00004.3f Hz", LRLCDWidget::NUMERIC);
-    DiodeLadderFilter *lpf = new DiodeLadderFilter(engineGetSampleRate());
+    DiodeLadderFilter lpf{engineGetSampleRate()};
 
     LRBigKnob *frqKnob = NULL;
     LRBigKnob *resKnob = NULL;
@@ -53,39 +53,40 @@ struct DiodeVCF : LRModule {
     LRPanel *panel;
 
     bool aged = false;
-    bool hidef = false;
+    bool lowLatency = false;
+    static const int DEFAULT_OVERSAMPLE = 1;
+    int oversample = DEFAULT_OVERSAMPLE;
 
+    ControlRamp resonance, saturation;
 
-    /* json_t *toJson() override {
-         json_t *rootJ = LRModule::toJson();
 
-         json_object_set_new(rootJ, "AGED", json_boolean(aged));
-         json_object_set_new(rootJ, "hidef", json_boolean(hidef));
-         return rootJ;
-     }
+    json_t *toJson() override {
+        json_t *rootJ = json_object();
 
+        json_object_set_new(rootJ, "lowLatency", json_boolean(lowLatency));
+        json_object_set_new(rootJ, JSON_OVERSAMPLE_KEY, json_integer(oversample));
+        return rootJ;
+    }
 
-     void fromJson(json_t *rootJ) override {
-         LRModule::fromJson(rootJ);
 
-         json_t *agedJ = json_object_get(rootJ, "AGED");
-         if (agedJ)
-             aged = json_boolean_value(agedJ);
+    void fromJson(json_t *rootJ) override {
+        json_t *lowLatencyJ = json_object_get(rootJ, "lowLatency");
+        if (lowLatencyJ)
+            lowLatency = json_boolean_value(lowLatencyJ);
 
-         json_t *hidefJ = json_object_get(rootJ, "hidef");
-         if (agedJ)
-             hidef = json_boolean_value(hidefJ);
+        oversample = oversamplingFromJson(rootJ, DEFAULT_OVERSAMPLE);
 
-         updateComponents();
-     }*/
+        updateComponents();
+    }
 
 
-    void step() override;
+    void controlStep() override;
+    void audioStep() override;
     void onSampleRateChange() override;
 };
 
 
-void DiodeVCF::step() {
+void DiodeVCF::controlStep() {
     float freqcv = 0, rescv = 0, satcv = 0;
 
     if (inputs[FREQUCENCY_CV_INPUT].active) {
@@ -115,23 +116,32 @@ void DiodeVCF::step() {
         saturateKnob->setIndicatorValue(params[SATURATE_PARAM].value + satcv);
     }
 
-    lpf->setFrequency(frq);
-    lpf->setResonance(res);
-    lpf->setSaturation(sat);
+    /* the stage coefficients are recomputed once per control step and glide there over the next
+     * control block, resonance and saturation ramp per sample */
+    resonance.set(res);
+    saturation.set(sat);
+
+    lpf.setFrequency(frq);
+    lpf.setLowLatency(lowLatency);
+    lpf.setOversampling(oversample);
+    lpf.invalidate();
+
+    lcd->value = lpf.getFreqHz();
+}
 
-    lpf->low = !hidef;
 
-    lcd->value = lpf->getFreqHz();
+void DiodeVCF::audioStep() {
+    lpf.setResonance(resonance.next());
+    lpf.setSaturation(saturation.next());
 
-    lpf->setIn(inputs[FILTER_INPUT].value / 10.f);
-    lpf->invalidate();
-    lpf->process();
+    lpf.setIn(inputs[FILTER_INPUT].value / 10.f);
+    lpf.process();
 
     /* compensate gain drop on resonance inc.
     float q = params[RES_PARAM].value * 1.8f + 1;*/
 
-    outputs[HP_OUTPUT].value = lpf->getOut2() * 6.5f;  // hipass
-    outputs[LP_OUTPUT].value = lpf->getOut() * 10.f;   // lowpass
+    outputs[HP_OUTPUT].value = lpf.getOut2() * 6.5f;  // hipass
+    outputs[LP_OUTPUT].value = lpf.getOut() * 10.f;   // lowpass
 }
 
 
@@ -142,7 +152,7 @@ void DiodeVCF::updateComponents() {
 
 void DiodeVCF::onSampleRateChange() {
     Module::onSampleRateChange();
-    lpf->setSamplerate(engineGetSampleRate());
+    lpf.setSamplerate(engineGetSampleRate());
 }
 
 
@@ -240,23 +250,18 @@ struct DiodeVCFAged : MenuItem {
 };
 */
 
-struct DiodeVCFHiDef : MenuItem {
+
+struct DiodeVCFLowLatency : MenuItem {
     DiodeVCF *diodeVCF;
 
 
     void onAction(EventAction &e) override {
-        if (diodeVCF->hidef) {
-            diodeVCF->hidef = false;
-        } else {
-            diodeVCF->hidef = true;
-        }
-
-        diodeVCF->updateComponents();
+        diodeVCF->lowLatency = !diodeVCF->lowLatency;
     }
 
 
     void step() override {
-        rightText = CHECKMARK(diodeVCF->hidef);
+        rightText = CHECKMARK(diodeVCF->lowLatency);
     }
 };
 
@@ -268,9 +273,11 @@ void DiodeVCFWidget::appendContextMenu(Menu *menu) {
     assert(diodeVCF);
 
 
-    DiodeVCFHiDef *mergeItemHiDef = MenuItem::create<DiodeVCFHiDef>("Use 4x oversampling");
-    mergeItemHiDef->diodeVCF = diodeVCF;
-    menu->addChild(mergeItemHiDef);
+    DiodeVCFLowLatency *lowLatencyItem = MenuItem::create<DiodeVCFLowLatency>("Low latency oversampling");
+    lowLatencyItem->diodeVCF = diodeVCF;
+    menu->addChild(lowLatencyItem);
+
+    appendOversamplingMenu(menu, &diodeVCF->oversample);
 }
 
 
@@ -46,27 +46,36 @@ struct Korg35 : LRModule {
     };
 
     LRKnob *frqKnob, *peakKnob, *saturateKnob;
-    Korg35Filter *filter = new Korg35Filter(engineGetSampleRate());
+    Korg35Filter filter{engineGetSampleRate()};
+
+    ControlRamp saturation;
 
     Korg35() : LRModule(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {}
 
 
-    void step() override {
-        filter->fc = params[FREQ_PARAM].value;
-        filter->peak = params[PEAK_PARAM].value;
-        filter->sat = params[SAT_PARAM].value;
+    void controlStep() override {
+        /* the filter glides to the new coefficients over the next control block */
+        filter.fc = params[FREQ_PARAM].value;
+        filter.peak = params[PEAK_PARAM].value;
+        filter.invalidate();
+
+        saturation.set(params[SAT_PARAM].value);
+    }
+
+
+    void audioStep() override {
+        filter.sat = saturation.next();
 
-        filter->in = inputs[FILTER_INPUT].value;
-        filter->invalidate();
-        filter->process();
+        filter.in = inputs[FILTER_INPUT].value;
+        filter.process();
 
-        outputs[LP_OUTPUT].value = filter->out;
+        outputs[LP_OUTPUT].value = filter.out;
     }
 
 
     void onSampleRateChange() override {
         Module::onSampleRateChange();
-        filter->setSamplerate(engineGetSampleRate());
+        filter.setSamplerate(engineGetSampleRate());
     }
 };
 
@@ -37,31 +37,68 @@ struct MS20Filter : LRModule {
         NUM_LIGHTS
     };
 
-    dsp::MS20zdf *ms20zdf = new dsp::MS20zdf(engineGetSampleRate());
+    dsp::MS20zdf ms20zdf{engineGetSampleRate()};
 
     LRBigKnob *frqKnob = NULL;
     LRMiddleKnob *peakKnob = NULL;
     LRMiddleKnob *driveKnob = NULL;
 
+    bool lowLatency = false;
+    static const int DEFAULT_OVERSAMPLE = RS_AUTO_FACTOR;
+    int oversample = DEFAULT_OVERSAMPLE;
+
+    float frequency = 0.f, peak = 0.f, drive = 0.f;        // knob values of the last control step
+    float frqDepth = 0.f, peakDepth = 0.f, gainDepth = 0.f;  // CV depths of the last control step
+
 
     MS20Filter() : LRModule(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {}
 
 
-    void step() override;
+    json_t *toJson() override {
+        json_t *rootJ = json_object();
+
+        json_object_set_new(rootJ, "lowLatency", json_boolean(lowLatency));
+        json_object_set_new(rootJ, JSON_OVERSAMPLE_KEY, json_integer(oversample));
+        return rootJ;
+    }
+
+
+    void fromJson(json_t *rootJ) override {
+        json_t *lowLatencyJ = json_object_get(rootJ, "lowLatency");
+        if (lowLatencyJ)
+            lowLatency = json_boolean_value(lowLatencyJ);
+
+        oversample = oversamplingFromJson(rootJ, DEFAULT_OVERSAMPLE);
+    }
+
+
+    void controlStep() override;
+    void audioStep() override;
     void onSampleRateChange() override;
 };
 
 
-void MS20Filter::step() {
+/**
+ * @brief Knobs, CV depths and settings, only the patched CV inputs are followed per sample
+ */
+void MS20Filter::controlStep() {
+    frequency = params[FREQUENCY_PARAM].value;
+    peak = params[PEAK_PARAM].value;
+    drive = params[DRIVE_PARAM].value;
+
+    frqDepth = 0.1f * quadraticBipolar(params[CUTOFF_CV_PARAM].value);
+    peakDepth = 0.1f * quadraticBipolar(params[PEAK_CV_PARAM].value);
+    gainDepth = 0.1f * quadraticBipolar(params[GAIN_CV_PARAM].value);
+
     /* compute control voltages */
-    float frqcv = inputs[CUTOFF_CV_INPUT].value * 0.1f * quadraticBipolar(params[CUTOFF_CV_PARAM].value);
-    float peakcv = inputs[PEAK_CV_INPUT].value * 0.1f * quadraticBipolar(params[PEAK_CV_PARAM].value);
-    float gaincv = inputs[GAIN_CV_INPUT].value * 0.1f * quadraticBipolar(params[GAIN_CV_PARAM].value);
+    float frqcv = inputs[CUTOFF_CV_INPUT].value * frqDepth;
+    float peakcv = inputs[PEAK_CV_INPUT].value * peakDepth;
+    float gaincv = inputs[GAIN_CV_INPUT].value * gainDepth;
 
     /* set cv modulated parameters */
-    ms20zdf->setFrequency(params[FREQUENCY_PARAM].value + frqcv);
-    ms20zdf->setPeak(params[PEAK_PARAM].value + peakcv);
-    ms20zdf->setDrive(params[DRIVE_PARAM].value + gaincv);
+    ms20zdf.setFrequency(frequency + frqcv);
+    ms20zdf.setPeak(peak + peakcv);
+    ms20zdf.setDrive(drive + gaincv);
 
     /* pass modulated parameter to knob widget for cv indicator */
     if (frqKnob != NULL && peakKnob != NULL && driveKnob != NULL) {
@@ -69,23 +106,44 @@ void MS20Filter::step() {
         peakKnob->setIndicatorActive(inputs[PEAK_CV_INPUT].active);
         driveKnob->setIndicatorActive(inputs[GAIN_CV_INPUT].active);
 
-        frqKnob->setIndicatorValue(params[FREQUENCY_PARAM].value + frqcv);
-        peakKnob->setIndicatorValue(params[PEAK_PARAM].value + peakcv);
-        driveKnob->setIndicatorValue(params[DRIVE_PARAM].value + gaincv);
+        frqKnob->setIndicatorValue(frequency + frqcv);
+        peakKnob->setIndicatorValue(peak + peakcv);
+        driveKnob->setIndicatorValue(drive + gaincv);
+    }
+
+    ms20zdf.setLowLatency(lowLatency);
+    ms20zdf.setOversampling(oversample);
+    ms20zdf.setType(params[MODE_SWITCH_PARAM].value);
+}
+
+
+/**
+ * @brief Patched CV inputs are passed on every sample with the depths of the control step, the
+ *        control rate parameters of the filter pick them up once per block and glide to them
+ */
+void MS20Filter::audioStep() {
+    if (inputs[CUTOFF_CV_INPUT].active) {
+        ms20zdf.setFrequency(frequency + inputs[CUTOFF_CV_INPUT].value * frqDepth);
+    }
+
+    if (inputs[PEAK_CV_INPUT].active) {
+        ms20zdf.setPeak(peak + inputs[PEAK_CV_INPUT].value * peakDepth);
+    }
+
+    if (inputs[GAIN_CV_INPUT].active) {
+        ms20zdf.setDrive(drive + inputs[GAIN_CV_INPUT].value * gainDepth);
     }
 
-    /* process signal */
-    ms20zdf->setType(params[MODE_SWITCH_PARAM].value);
-    ms20zdf->setIn(inputs[FILTER_INPUT].value);
-    ms20zdf->process();
+    ms20zdf.setIn(inputs[FILTER_INPUT].value);
+    ms20zdf.process();
 
-    outputs[FILTER_OUTPUT].value = ms20zdf->getLPOut();
+    outputs[FILTER_OUTPUT].value = ms20zdf.getLPOut();
 }
 
 
 void MS20Filter::onSampleRateChange() {
     Module::onSampleRateChange();
-    ms20zdf->updateSampleRate(engineGetSampleRate());
+    ms20zdf.updateSampleRate(engineGetSampleRate());
 }
 
 
@@ -94,6 +152,7 @@ void MS20Filter::onSampleRateChange() {
  */
 struct MS20FilterWidget : LRModuleWidget {
     MS20FilterWidget(MS20Filter *module);
+    void appendContextMenu(Menu *menu) override;
 };
 
 
@@ -148,4 +207,33 @@ MS20FilterWidget::MS20FilterWidget(MS20Filter *module) : LRModuleWidget(module)
 }
 
 
+struct MS20FilterLowLatency : MenuItem {
+    MS20Filter *ms20Filter;
+
+
+    void onAction(EventAction &e) override {
+        ms20Filter->lowLatency = !ms20Filter->lowLatency;
+    }
+
+
+    void step() override {
+        rightText = CHECKMARK(ms20Filter->lowLatency);
+    }
+};
+
+
+void MS20FilterWidget::appendContextMenu(Menu *menu) {
+    menu->addChild(MenuEntry::create());
+
+    MS20Filter *ms20Filter = dynamic_cast<MS20Filter *>(module);
+    assert(ms20Filter);
+
+    MS20FilterLowLatency *lowLatencyItem = MenuItem::create<MS20FilterLowLatency>("Low latency oversampling");
+    lowLatencyItem->ms20Filter = ms20Filter;
+    menu->addChild(lowLatencyItem);
+
+    appendOversamplingMenu(menu, &ms20Filter->oversample);
+}
+
+
 Model *modelMS20Filter = Model::create<MS20Filter, MS20FilterWidget>("Lindenberg Research", "MS20 VCF", "Valerie MS20 Filter", FILTER_TAG);
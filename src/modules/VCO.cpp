@@ -41,10 +41,14 @@ struct VCO : LRModule {
         NUM_LIGHTS
     };
 
-    DSPBLOscillator *osc = new DSPBLOscillator(engineGetSampleRate());
+    DSPBLOscillator osc{engineGetSampleRate()};
     LRLCDWidget *lcd = new LRLCDWidget(10, "%00004.3f Hz", LRLCDWidget::NUMERIC);
     LRBigKnob *frqKnob = NULL;
 
+    ControlRamp pw;
+    float fmDepth = 0.f, tune = 0.f, octave = 0.f;
+    float sawMix = 0.f, pulseMix = 0.f, sineMix = 0.f, triMix = 0.f;
+
 
     VCO() : LRModule(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {}
 
@@ -70,18 +74,19 @@ struct VCO : LRModule {
 
     void onRandomize() override;
 
-    void step() override;
+    void controlStep() override;
+    void audioStep() override;
     void onSampleRateChange() override;
 };
 
 
-void VCO::step() {
-    Module::step();
-
-    float fm = clamp(inputs[FM_CV_INPUT].value, -CV_BOUNDS, CV_BOUNDS) * 0.4f * quadraticBipolar(params[FM_CV_PARAM].value);
-    float tune = params[FREQUENCY_PARAM].value;
+void VCO::controlStep() {
     float pw;
 
+    fmDepth = 0.4f * quadraticBipolar(params[FM_CV_PARAM].value);
+    tune = params[FREQUENCY_PARAM].value;
+    octave = params[OCTAVE_PARAM].value;
+
     if (inputs[PW_CV_INPUT].active) {
         pw = clamp(inputs[PW_CV_INPUT].value, -CV_BOUNDS, CV_BOUNDS) * 0.6f * quadraticBipolar(params[PW_CV_PARAM].value / 2.f) + 1;
         pw = clamp(pw, 0.01, 1.99);
@@ -89,47 +94,61 @@ void VCO::step() {
         pw = params[PW_CV_PARAM].value * 0.99f + 1;
     }
 
+    VCO::pw.set(pw);
+
+    sawMix = params[SAW_PARAM].value;
+    pulseMix = params[PULSE_PARAM].value;
+    sineMix = params[SINE_PARAM].value;
+    triMix = params[TRI_PARAM].value;
+
     if (frqKnob != NULL) {
+        float fm = clamp(inputs[FM_CV_INPUT].value, -CV_BOUNDS, CV_BOUNDS) * fmDepth;
+
         frqKnob->setIndicatorActive(inputs[FM_CV_INPUT].active);
         frqKnob->setIndicatorValue((params[FREQUENCY_PARAM].value + 1) / 2 + (fm / 2));
     }
 
-    osc->setInputs(inputs[VOCT1_INPUT].value, inputs[VOCT2_INPUT].value, fm, tune, params[OCTAVE_PARAM].value);
-    osc->setPulseWidth(pw);
+    /* for LFO mode */
+    if (osc.isLFO())
+        lights[LFO_LIGHT].setBrightnessSmooth(osc.getSineWave() / 10.f + 0.3f, CONTROL_RATE_DIVIDER);
+    else lights[LFO_LIGHT].value = 0.f;
 
-    osc->process();
+    lcd->active = osc.isLFO();
+    lcd->value = osc.getFrequency();
+}
 
-    outputs[SAW_OUTPUT].value = osc->getSawWave();
-    outputs[PULSE_OUTPUT].value = osc->getPulseWave();
-    outputs[SINE_OUTPUT].value = osc->getSineWave();
-    outputs[TRI_OUTPUT].value = osc->getTriWave();
-    outputs[NOISE_OUTPUT].value = osc->getNoise();
+
+void VCO::audioStep() {
+    float fm = clamp(inputs[FM_CV_INPUT].value, -CV_BOUNDS, CV_BOUNDS) * fmDepth;
+
+    osc.setInputs(inputs[VOCT1_INPUT].value, inputs[VOCT2_INPUT].value, fm, tune, octave);
+    osc.setPulseWidth(pw.next());
+
+    osc.process();
+
+    outputs[SAW_OUTPUT].value = osc.getSawWave();
+    outputs[PULSE_OUTPUT].value = osc.getPulseWave();
+    outputs[SINE_OUTPUT].value = osc.getSineWave();
+    outputs[TRI_OUTPUT].value = osc.getTriWave();
+    outputs[NOISE_OUTPUT].value = osc.getNoise();
 
 
     if (outputs[MIX_OUTPUT].active) {
         float mix = 0.f;
 
-        mix += osc->getSawWave() * params[SAW_PARAM].value;
-        mix += osc->getPulseWave() * params[PULSE_PARAM].value;
-        mix += osc->getSineWave() * params[SINE_PARAM].value;
-        mix += osc->getTriWave() * params[TRI_PARAM].value;
+        mix += osc.getSawWave() * sawMix;
+        mix += osc.getPulseWave() * pulseMix;
+        mix += osc.getSineWave() * sineMix;
+        mix += osc.getTriWave() * triMix;
 
         outputs[MIX_OUTPUT].value = mix;
     }
-
-    /* for LFO mode */
-    if (osc->isLFO())
-        lights[LFO_LIGHT].setBrightnessSmooth(osc->getSineWave() / 10.f + 0.3f);
-    else lights[LFO_LIGHT].value = 0.f;
-
-    lcd->active = osc->isLFO();
-    lcd->value = osc->getFrequency();
 }
 
 
 void VCO::onSampleRateChange() {
     Module::onSampleRateChange();
-    osc->updateSampleRate(engineGetSampleRate());
+    osc.updateSampleRate(engineGetSampleRate());
 }
 
 
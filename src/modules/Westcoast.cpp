@@ -54,33 +54,62 @@ struct Westcoast : LRModule {
     Westcoast() : LRModule(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS) {}
 
 
-    dsp::LockhartWavefolder *hs = new dsp::LockhartWavefolder(engineGetSampleRate());
-    dsp::SergeWavefolder *sg = new dsp::SergeWavefolder(engineGetSampleRate());
-    dsp::Saturator *saturator = new dsp::Saturator(engineGetSampleRate());
-    dsp::Hardclip *hardclip = new dsp::Hardclip(engineGetSampleRate());
-    dsp::ReShaper *reshaper = new dsp::ReShaper(engineGetSampleRate());
-    dsp::Overdrive *overdrive = new dsp::Overdrive(engineGetSampleRate());
-    dsp::FastTan *fastTan = new dsp::FastTan(engineGetSampleRate());
+    dsp::LockhartWavefolder hs{engineGetSampleRate()};
+    dsp::SergeWavefolder sg{engineGetSampleRate()};
+    dsp::Saturator saturator{engineGetSampleRate()};
+    dsp::Hardclip hardclip{engineGetSampleRate()};
+    dsp::ReShaper reshaper{engineGetSampleRate()};
+    dsp::Overdrive overdrive{engineGetSampleRate()};
+    dsp::FastTan fastTan{engineGetSampleRate()};
 
     LRBigKnob *gainBtn = NULL;
     LRMiddleKnob *biasBtn = NULL;
 
-    void step() override;
+    bool lowLatency = false;
+    bool tabulated = false;             // Lockhart and Serge stages read the antiderivative tables
+    static const int DEFAULT_OVERSAMPLE = RS_AUTO_FACTOR;
+    int oversample = DEFAULT_OVERSAMPLE;    // used by the oversampled stages ReShaper and Valerie
+
+    ControlRamp gain, bias;
+    int type = SERGE;
+
+
+    json_t *toJson() override {
+        json_t *rootJ = json_object();
+
+        json_object_set_new(rootJ, "lowLatency", json_boolean(lowLatency));
+        json_object_set_new(rootJ, "tabulated", json_boolean(tabulated));
+        json_object_set_new(rootJ, JSON_OVERSAMPLE_KEY, json_integer(oversample));
+        return rootJ;
+    }
+
+
+    void fromJson(json_t *rootJ) override {
+        json_t *lowLatencyJ = json_object_get(rootJ, "lowLatency");
+        if (lowLatencyJ)
+            lowLatency = json_boolean_value(lowLatencyJ);
+
+        json_t *tabulatedJ = json_object_get(rootJ, "tabulated");
+        if (tabulatedJ)
+            tabulated = json_boolean_value(tabulatedJ);
+
+        oversample = oversamplingFromJson(rootJ, DEFAULT_OVERSAMPLE);
+    }
+
+
+    void controlStep() override;
+    void audioStep() override;
     void onSampleRateChange() override;
+    void updateLatency();
+    void updateOversampling();
+    void updateTabulated();
 };
 
 
-void Westcoast::step() {
+void Westcoast::controlStep() {
     float gaincv = 0;
     float biascv = 0;
 
-    /* not connected */
-    if (!inputs[SHAPER_INPUT].active) {
-        outputs[SHAPER_OUTPUT].value = 0.f;
-
-        return;
-    }
-
     if (inputs[CV_GAIN_INPUT].active) {
         gaincv = inputs[CV_GAIN_INPUT].value * quadraticBipolar(params[CV_GAIN_PARAM].value) * 4.0f;
     }
@@ -97,72 +126,91 @@ void Westcoast::step() {
         biasBtn->setIndicatorValue((params[BIAS_PARAM].value + (biascv + 6)) / 12);
     }
 
+    updateLatency();
+    updateOversampling();
+    updateTabulated();
+
+    gain.set(params[GAIN_PARAM].value + gaincv);
+    bias.set(params[BIAS_PARAM].value + biascv);
+    type = lround(params[TYPE_PARAM].value);
+}
+
+
+void Westcoast::audioStep() {
+    float gain = Westcoast::gain.next();
+    float bias = Westcoast::bias.next();
+
+    /* not connected */
+    if (!inputs[SHAPER_INPUT].active) {
+        outputs[SHAPER_OUTPUT].value = 0.f;
+
+        return;
+    }
+
     float out;
-    float gain = params[GAIN_PARAM].value + gaincv;
-    float bias = params[BIAS_PARAM].value + biascv;
 
-    switch (lround(params[TYPE_PARAM].value)) {
+    switch (type) {
         case LOCKHART:  // Lockhart Model
-            hs->setGain(gain);
-            hs->setBias(bias);
-            hs->setIn(inputs[SHAPER_INPUT].value);
+            hs.setGain(gain);
+            hs.setBias(bias);
+            hs.setIn(inputs[SHAPER_INPUT].value);
 
-            hs->process();
-            out = (float) hs->getOut();
+            hs.process();
+            out = (float) hs.getOut();
             break;
 
         case SERGE:     // Serge Model
-            sg->setGain(gain);
-            sg->setBias(bias);
-            sg->setIn(inputs[SHAPER_INPUT].value);
+            sg.setGain(gain);
+            sg.setBias(bias);
+            sg.setIn(inputs[SHAPER_INPUT].value);
 
-            sg->process();
-            out = (float) sg->getOut();
+            sg.process();
+            out = (float) sg.getOut();
             break;
 
         case SATURATE: // Saturator
-            saturator->setGain(gain);
-            saturator->setBias(bias);
-            saturator->setIn(inputs[SHAPER_INPUT].value);
+            saturator.setGain(gain);
+            saturator.setBias(bias);
+            saturator.setIn(inputs[SHAPER_INPUT].value);
 
-            saturator->process();
-            out = (float) saturator->getOut();
+            saturator.process();
+            out = (float) saturator.getOut();
             break;
 
         case HARDCLIP: // Hardclip
-            hardclip->setGain(gain);
-            hardclip->setBias(bias);
-            hardclip->setIn(inputs[SHAPER_INPUT].value);
+            hardclip.setGain(gain);
+            hardclip.setBias(bias);
+            hardclip.setIn(inputs[SHAPER_INPUT].value);
 
-            hardclip->process();
-            out = (float) hardclip->getOut();
+            hardclip.process();
+            out = (float) hardclip.getOut();
             break;
 
         case RESHAPER: // ReShaper
-            reshaper->setGain(gain);
-            reshaper->setBias(bias);
-            reshaper->setIn(inputs[SHAPER_INPUT].value);
+            reshaper.setGain(gain);
+            reshaper.setBias(bias);
+            reshaper.setIn(inputs[SHAPER_INPUT].value);
 
-            reshaper->process();
-            out = (float) reshaper->getOut();
+            reshaper.process();
+            out = (float) reshaper.getOut();
             break;
 
         case OVERDRIVE: // Overdrive
-            overdrive->setGain(gain);
-            overdrive->setBias(bias);
-            overdrive->setIn(inputs[SHAPER_INPUT].value);
+            overdrive.setGain(gain);
+            overdrive.setBias(bias);
+            overdrive.setIn(inputs[SHAPER_INPUT].value);
 
-            overdrive->process();
-            out = (float) overdrive->getOut();
+            overdrive.process();
+            out = (float) overdrive.getOut();
             break;
 
         case VALERIE: // Overdrive
-            fastTan->setGain(gain);
-            fastTan->setBias(bias);
-            fastTan->setIn(inputs[SHAPER_INPUT].value);
+            fastTan.setGain(gain);
+            fastTan.setBias(bias);
+            fastTan.setIn(inputs[SHAPER_INPUT].value);
 
-            fastTan->process();
-            out = (float) fastTan->getOut();
+            fastTan.process();
+            out = (float) fastTan.getOut();
             break;
 
         default: // invalid state, should not happen
@@ -178,14 +226,52 @@ void Westcoast::step() {
 void Westcoast::onSampleRateChange() {
     Module::onSampleRateChange();
 
-    hs->setSamplerate(engineGetSampleRate());
-    sg->setSamplerate(engineGetSampleRate());
-    saturator->setSamplerate(engineGetSampleRate());
+    hs.setSamplerate(engineGetSampleRate());
+    sg.setSamplerate(engineGetSampleRate());
+    saturator.setSamplerate(engineGetSampleRate());
+    hardclip.setSamplerate(engineGetSampleRate());
+    reshaper.setSamplerate(engineGetSampleRate());
+    overdrive.setSamplerate(engineGetSampleRate());
+    fastTan.setSamplerate(engineGetSampleRate());
+}
+
+
+/**
+ * @brief Pass the latency mode to all shapers, stages without oversampling just ignore it
+ */
+void Westcoast::updateLatency() {
+    hs.setLowLatency(lowLatency);
+    sg.setLowLatency(lowLatency);
+    saturator.setLowLatency(lowLatency);
+    hardclip.setLowLatency(lowLatency);
+    reshaper.setLowLatency(lowLatency);
+    overdrive.setLowLatency(lowLatency);
+    fastTan.setLowLatency(lowLatency);
+}
+
+
+/**
+ * @brief Switch the Lockhart and Serge stages to the antiderivative tables on the audio thread,
+ *        the tables are already built, so this only swaps their pointers
+ */
+void Westcoast::updateTabulated() {
+    hs.setTabulated(tabulated);
+    sg.setTabulated(tabulated);
+}
+
+
+/**
+ * @brief Pass the selected factor to the stages which are oversampled by design
+ */
+void Westcoast::updateOversampling() {
+    reshaper.setOversampling(oversample);
+    fastTan.setOversampling(oversample);
 }
 
 
 struct WestcoastWidget : LRModuleWidget {
     WestcoastWidget(Westcoast *module);
+    void appendContextMenu(Menu *menu) override;
 };
 
 
@@ -251,5 +337,53 @@ WestcoastWidget::WestcoastWidget(Westcoast *module) : LRModuleWidget(module) {
 }
 
 
+struct WestcoastLowLatency : MenuItem {
+    Westcoast *westcoast;
+
+
+    void onAction(EventAction &e) override {
+        westcoast->lowLatency = !westcoast->lowLatency;
+    }
+
+
+    void step() override {
+        rightText = CHECKMARK(westcoast->lowLatency);
+    }
+};
+
+
+struct WestcoastTabulated : MenuItem {
+    Westcoast *westcoast;
+
+
+    void onAction(EventAction &e) override {
+        westcoast->tabulated = !westcoast->tabulated;
+    }
+
+
+    void step() override {
+        rightText = CHECKMARK(westcoast->tabulated);
+    }
+};
+
+
+void WestcoastWidget::appendContextMenu(Menu *menu) {
+    menu->addChild(MenuEntry::create());
+
+    Westcoast *westcoast = dynamic_cast<Westcoast *>(module);
+    assert(westcoast);
+
+    WestcoastLowLatency *lowLatencyItem = MenuItem::create<WestcoastLowLatency>("Low latency oversampling");
+    lowLatencyItem->westcoast = westcoast;
+    menu->addChild(lowLatencyItem);
+
+    WestcoastTabulated *tabulatedItem = MenuItem::create<WestcoastTabulated>("Tabulated wavefolders");
+    tabulatedItem->westcoast = westcoast;
+    menu->addChild(tabulatedItem);
+
+    appendOversamplingMenu(menu, &westcoast->oversample);
+}
+
+
 Model *modelWestcoast = Model::create<Westcoast, WestcoastWidget>("Lindenberg Research", "Westcoast VCS",
                                                                   "Westcoast Complex Shaper", WAVESHAPER_TAG);